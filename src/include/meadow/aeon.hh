@@ -23,14 +23,23 @@ JSON interface -- serializer and deserializer
 - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - 
 */
 
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iterator>
 #include <memory>
+#include <memory_resource>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <variant>
 #include <vector>
 
+#include "flat_map.hh"
+
 namespace meadow {
 	struct aeon;
+	struct buffer;
 }
 
 struct meadow::aeon final {
@@ -39,37 +48,55 @@ struct meadow::aeon final {
 	using int_t = int_fast64_t;
 	using flt_t = double;
 	using str_t = std::string;
-	using ary_t = std::vector<aeon>;
-	using map_t = std::unordered_map<str_t, aeon>;
+	using ary_t = std::pmr::vector<aeon>;
+	using map_t = flat_map<aeon>; // insertion ordered, serialized in that order
 	
-private:
-	using variant_t = std::variant<nul_t, bool, int_t, flt_t, str_t, ary_t, map_t>;
-public:
-	std::unique_ptr<variant_t> value;
+	enum class type_t : uint8_t {
+		nul,
+		boolean,
+		integer,
+		floating,
+		string,
+		array,
+		map,
+	};
 	
 	// ================================================================
 	// CONSTRUCTORS
 	// ================================================================
 	
-	inline aeon() : value(std::make_unique<variant_t>()) {}
+	inline aeon() noexcept : m_int(0) {}
 	template <typename T, std::enable_if_t<std::is_same<T, bool>::value, int> = 0>
-	inline aeon(bool const & v) : value(std::make_unique<variant_t>(v)) {}
-	template <typename T, std::enable_if_t<std::is_integral<T>::value, int> = 0>
-	inline aeon(T const & v) : value(std::make_unique<variant_t>(static_cast<int_t>(v))) {}
+	inline aeon(T const & v) noexcept : m_type(type_t::boolean), m_bool(v) {}
+	template <typename T, std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value, int> = 0>
+	inline aeon(T const & v) noexcept : m_type(type_t::integer), m_int(static_cast<int_t>(v)) {}
 	template <typename T, std::enable_if_t<std::is_floating_point<T>::value, int> = 0>
-	inline aeon(T const & v) : value(std::make_unique<variant_t>(static_cast<flt_t>(v))) {}
-	inline aeon(str_t const & v) : value(std::make_unique<variant_t>(v)) {}
-	inline aeon(ary_t const & v) : value(std::make_unique<variant_t>(v)) {}
-	inline aeon(map_t const & v) : value(std::make_unique<variant_t>(v)) {}
+	inline aeon(T const & v) noexcept : m_type(type_t::floating), m_flt(static_cast<flt_t>(v)) {}
+	inline aeon(char const * v) : aeon(std::string_view { v }) {}
+	inline aeon(std::string_view v) : m_type(type_t::string), m_str(new str_t(v)) {}
+	inline aeon(str_t const & v) : m_type(type_t::string), m_str(new str_t(v)) {}
+	inline aeon(str_t && v) : m_type(type_t::string), m_str(new str_t(std::move(v))) {}
+	inline aeon(ary_t const & v) : m_type(type_t::array), m_ary(new cached<ary_t>(v)) {}
+	inline aeon(ary_t && v) : m_type(type_t::array), m_ary(new cached<ary_t>(std::move(v))) {}
+	inline aeon(map_t const & v) : m_type(type_t::map), m_map(new cached<map_t>(v)) {}
+	inline aeon(map_t && v) : m_type(type_t::map), m_map(new cached<map_t>(std::move(v))) {}
+	
+	aeon(aeon const & other);
+	inline aeon(aeon && other) noexcept : m_int(0) { take(other); }
 	
-	inline aeon(aeon const & other) : value(std::make_unique<variant_t>(*other.value)) {}
-	inline aeon(aeon && other) : value(std::make_unique<variant_t>(std::move(*other.value))) {}
+	inline ~aeon() { reset(); }
 	
 	// ================================================================
 	// GENERAL
 	// ================================================================
 	
 	[[nodiscard]] size_t size() const;
+	[[nodiscard]] inline type_t type() const { return m_type; }
+	
+	// Structural, consistent with == and independent of the order of map entries. Computed afresh over the whole tree on
+	// every call, as a change made through a held reference to an element cannot reach the containers above it. Each
+	// container records its hash as it goes for diff to reuse, so even const access must not be concurrent with it.
+	[[nodiscard]] uint64_t hash() const;
 	
 	// ================================================================
 	// TYPE CHECKS
@@ -96,7 +123,7 @@ public:
 	flt_t & floating();
 	[[nodiscard]] flt_t const & floating() const;
 	str_t & string();
-	[[nodiscard]] str_t const & string() const;
+	[[nodiscard]] std::string_view string() const;
 	ary_t & array();
 	[[nodiscard]] ary_t const & array() const;
 	map_t & map();
@@ -125,39 +152,295 @@ public:
 		std::string m_what;
 	};
 	
-	[[nodiscard]] static std::string jsonify_string(std::string const & str);
+	[[nodiscard]] static std::string jsonify_string(std::string_view str);
+	
+	// Serialization is a single pass over the tree, streamed through a bounded internal chunk that is handed to the sink
+	// whenever it fills, so output of any size is produced in constant memory.
+	using sink_fn = void (*)(void * ctx, char const * data, size_t size);
 	
 	[[nodiscard]] std::string serialize_json() const;
+	void serialize_json(sink_fn, void * ctx) const;
+	void serialize_json(buffer &) const;
+	void serialize_json(int fd) const; // throws std::system_error if writing fails
+	
+	// Output options, written in the same single pass as compact output. Indentation puts every element and map entry on a
+	// line of its own. Canonical output sorts map entries by key, comparing UTF-16 code units as RFC 8785 does, and writes
+	// negative zero as zero, so equal trees always serialize to identical bytes. Unlike RFC 8785, integers are written
+	// exactly and floats keep their fraction so they read back as floats. ASCII output escapes every other character.
+	struct format;
+	
+	[[nodiscard]] std::string serialize_json(format const &) const;
+	void serialize_json(format const &, sink_fn, void * ctx) const;
+	void serialize_json(format const &, buffer &) const;
+	void serialize_json(format const &, int fd) const; // throws std::system_error if writing fails
+	
+	template <typename T, std::enable_if_t<std::output_iterator<T, char>, int> = 0>
+	T serialize_json(T it) const {
+		serialize_json([](void * ctx, char const * data, size_t size){
+			T & it = *reinterpret_cast<T *>(ctx);
+			it = std::copy(data, data + size, it);
+		}, &it);
+		return it;
+	}
+	
+	// The counterpart of handler, for producing JSON without building a tree. Separators are inserted automatically.
+	struct emitter;
+	
 	[[nodiscard]] static aeon deserialize_json(char const * begin, char const * end);
 	
 	[[nodiscard]] inline static aeon deserialize_json(std::string_view str) { return deserialize_json(str.data(), str.data() + str.size()); }
 	
+	// ================================================================
+	// BINARY SERIALIZATION
+	// ================================================================
+	
+	// Values are encoded as CBOR (RFC 8949) with definite lengths, integers and floats are stored natively (floats in 32
+	// bits whenever that is lossless). Decoding additionally accepts half precision floats and ignores tags, byte strings
+	// are read as strings. Indefinite lengths and map keys other than strings are rejected with deserialize_exception.
+	
+	[[nodiscard]] std::string serialize_binary() const;
+	void serialize_binary(sink_fn, void * ctx) const;
+	void serialize_binary(buffer &) const;
+	void serialize_binary(int fd) const; // throws std::system_error if writing fails
+	
+	template <typename T, std::enable_if_t<std::output_iterator<T, char>, int> = 0>
+	T serialize_binary(T it) const {
+		serialize_binary([](void * ctx, char const * data, size_t size){
+			T & it = *reinterpret_cast<T *>(ctx);
+			it = std::copy(data, data + size, it);
+		}, &it);
+		return it;
+	}
+	
+	[[nodiscard]] static aeon deserialize_binary(char const * begin, char const * end);
+	[[nodiscard]] inline static aeon deserialize_binary(std::string_view str) { return deserialize_binary(str.data(), str.data() + str.size()); }
+	
+	// ================================================================
+	// DOCUMENTS
+	// ================================================================
+	
+	// A read-only tree whose nodes, strings, and containers all live in a single monotonic arena owned by the document.
+	// Building one is a sequence of bump allocations and destroying it releases the arena without visiting any node.
+	// Copying the root (or any subtree) out of a document produces an ordinary, independently owned aeon.
+	struct document;
+	
+	// Parses into the given document, releasing whatever it held before.
+	static aeon const & deserialize_json(char const * begin, char const * end, document &);
+	inline static aeon const & deserialize_json(std::string_view str, document & doc) { return deserialize_json(str.data(), str.data() + str.size(), doc); }
+	static aeon const & deserialize_binary(char const * begin, char const * end, document &);
+	inline static aeon const & deserialize_binary(std::string_view str, document & doc) { return deserialize_binary(str.data(), str.data() + str.size(), doc); }
+	
+	// ================================================================
+	// FROZEN DOCUMENTS
+	// ================================================================
+	
+	// A position independent image of a tree, written once and then mapped and queried in place. Values are fixed size slots
+	// holding scalars and strings of up to 8 bytes inline, anything larger is referred to by its offset within the image.
+	// Map keys are sorted for binary search, so maps read back in key order rather than insertion order. Images use the byte
+	// order of the machine that wrote them. Nesting deeper than 1024 containers throws std::length_error.
+	struct frozen;
+	
+	[[nodiscard]] std::string serialize_frozen() const;
+	void serialize_frozen(sink_fn, void * ctx) const;
+	void serialize_frozen(buffer &) const;
+	void serialize_frozen(int fd) const; // throws std::system_error if writing fails
+	
+	// ================================================================
+	// BORROWED PARSING
+	// ================================================================
+	
+	// Strings that need no unescaping are left as views into the input rather than copied, so the input must outlive the
+	// returned tree. Copies of a borrowed tree are always independent of the input.
+	[[nodiscard]] static aeon deserialize_json_borrowed(char const * begin, char const * end);
+	static aeon const & deserialize_json_borrowed(char const * begin, char const * end, document &);
+	
+	[[nodiscard]] inline static aeon deserialize_json_borrowed(std::string_view str) { return deserialize_json_borrowed(str.data(), str.data() + str.size()); }
+	inline static aeon const & deserialize_json_borrowed(std::string_view str, document & doc) { return deserialize_json_borrowed(str.data(), str.data() + str.size(), doc); }
+	
+	// ================================================================
+	// LAZY PARSING
+	// ================================================================
+	
+	// Only the top level is parsed, nested arrays and maps are recorded as spans of the input and parsed a level at a time
+	// when first accessed (array(), map(), operator [], size(), comparison and so on). Untouched containers are never built
+	// and serialize to JSON as their original bytes. Strings are borrowed, so the input must outlive the tree, and copies
+	// of untouched containers stay lazy. Errors within a nested container are thrown as deserialize_exception when it is
+	// first accessed. Since access parses in place, even const access to a lazy tree must not be concurrent. The structural
+	// index of the input is kept for as long as any container still lazy refers to it, so that each level is parsed
+	// without indexing its contents again.
+	[[nodiscard]] static aeon deserialize_json_lazy(char const * begin, char const * end);
+	[[nodiscard]] inline static aeon deserialize_json_lazy(std::string_view str) { return deserialize_json_lazy(str.data(), str.data() + str.size()); }
+	
+	// whether this is a container that has not been parsed yet
+	[[nodiscard]] inline bool is_lazy() const { return m_lazy; }
+	
+	// ================================================================
+	// STRICT PARSING
+	// ================================================================
+	
+	// For untrusted input. The grammar is enforced exactly (separators only where they belong, RFC 8259 numbers, nothing
+	// but whitespace after the value) and input beyond any of the limits throws limit_exception as soon as it is seen.
+	// Parsing never recurses, so nesting only costs what max_depth allows.
+	struct limits;
+	
+	struct limit_exception : public deserialize_exception {
+		using deserialize_exception::deserialize_exception;
+	};
+	
+	[[nodiscard]] static aeon deserialize_json(char const * begin, char const * end, limits const &);
+	static aeon const & deserialize_json(char const * begin, char const * end, document &, limits const &);
+	
+	[[nodiscard]] inline static aeon deserialize_json(std::string_view str, limits const & lim) { return deserialize_json(str.data(), str.data() + str.size(), lim); }
+	inline static aeon const & deserialize_json(std::string_view str, document & doc, limits const & lim) { return deserialize_json(str.data(), str.data() + str.size(), doc, lim); }
+	
+	// Checks the input as strict parsing would, throwing the same exceptions, without converting or building anything.
+	static void validate_json(char const * begin, char const * end, limits const &);
+	inline static void validate_json(std::string_view str, limits const & lim) { validate_json(str.data(), str.data() + str.size(), lim); }
+	
+	// ================================================================
+	// EVENT PARSING
+	// ================================================================
+	
+	// The first value in the input is reported as a sequence of events instead of being built into a tree. Every map value
+	// is preceded by a key event. Strings and keys are views which remain valid only until the next event.
+	
+	enum class event_t : uint8_t {
+		none,
+		null,
+		boolean,
+		integer,
+		floating,
+		string,
+		key,
+		start_array,
+		end_array,
+		start_map,
+		end_map,
+	};
+	
+	struct reader;  // pull
+	struct handler; // push
+	
+	static void deserialize_json(char const * begin, char const * end, handler &);
+	inline static void deserialize_json(std::string_view str, handler & h) { deserialize_json(str.data(), str.data() + str.size(), h); }
+	
+	// ================================================================
+	// INCREMENTAL PARSING
+	// ================================================================
+	
+	// Input arriving in arbitrary pieces (e.g. from a socket) is fed to a parser as it comes, which yields each top-level
+	// value as soon as its last byte arrives. Top-level values are separated by whitespace, only the bytes of an incomplete
+	// value are retained between feeds.
+	
+	struct parser;
+	
+	// ================================================================
+	// NDJSON
+	// ================================================================
+	
+	// Newline delimited JSON, one value per line with blank lines skipped. The input is split into line aligned chunks which
+	// are parsed concurrently by up to the given number of threads (0 for one per core), records are nonetheless delivered
+	// in input order and the callback is only ever invoked from the calling thread. The first invalid line, including one
+	// with anything but whitespace after its value, throws deserialize_exception naming the byte offset the line starts at,
+	// once every record before it has been delivered. Threads are started by each call and joined before it returns, input
+	// of a single chunk is parsed on the calling thread alone.
+	
+	using record_fn = std::function<void(aeon &&)>;
+	
+	static void deserialize_ndjson(std::string_view str, record_fn const & fn, unsigned threads = 0);
+	[[nodiscard]] static std::vector<aeon> deserialize_ndjson(std::string_view str, unsigned threads = 0);
+	
+	// The file is memory mapped for the duration of the call, and each chunk is read ahead as a thread takes it rather than
+	// the whole file up front. Failure to open or map it throws std::system_error.
+	static void deserialize_ndjson_file(char const * path, record_fn const & fn, unsigned threads = 0);
+	[[nodiscard]] static std::vector<aeon> deserialize_ndjson_file(char const * path, unsigned threads = 0);
+	
+	// ================================================================
+	// KEY INTERNING
+	// ================================================================
+	
+	// A key pool holds a single copy of every key interned in it, shared by any number of maps and documents. Interned
+	// keys carry their hash and compare by pointer, and copies of a map share them rather than allocating. The pool is
+	// safe to use from concurrent parsers and must outlive every map holding its keys.
+	
+	using key_t = map_t::key_type;
+	struct key_pool;
+	
+	// ================================================================
+	// PATHS
+	// ================================================================
+	
+	// A JSON Pointer (RFC 6901) compiled once and evaluated any number of times, with every key hashed up front. As an
+	// extension a "*" segment matches every element of an array or value of a map, a literal "*" key is written "~2".
+	// Evaluation never modifies or allocates, missing members and type mismatches simply do not match.
+	
+	struct path;
+	
+	// ================================================================
+	// DIFF AND PATCH
+	// ================================================================
+	
+	struct patch_exception : public std::exception {
+		patch_exception() = delete;
+		patch_exception(std::string const & msg) : m_what(msg) {}
+		virtual char const * what() const noexcept override { return m_what.c_str(); }
+	private:
+		std::string m_what;
+	};
+	
+	// Produces a JSON Patch (RFC 6902) that turns from into to. Both trees are hashed once up front, then containers with
+	// differing hashes are descended into and those with equal hashes are compared to confirm they are unchanged.
+	// Arrays are aligned on their common prefix and suffix, the elements in between are diffed pairwise with the surplus
+	// removed or added at the end.
+	[[nodiscard]] static aeon diff(aeon const & from, aeon const & to);
+	
+	// Applies a JSON Patch in place, the rvalue form moves values out of the patch rather than copying them. An invalid
+	// operation or failed test throws patch_exception, the operations before it remain applied.
+	void apply_patch(aeon const & patch);
+	void apply_patch(aeon && patch);
+	
+	// Applies a JSON Merge Patch (RFC 7386) in place: maps merge recursively, null members are removed, and any other value
+	// replaces the target.
+	void merge_patch(aeon const & patch);
+	void merge_patch(aeon && patch);
+	
 	// ================================================================
 	// OPERATORS
 	// ================================================================
 	
-	inline aeon & operator = (aeon const & other) { *value = *other.value; return *this; }
-	inline aeon & operator = (aeon && other) { *value = std::move(*other.value); return *this; }
+	// the source may live within this value (e.g. a = a[0]), so it is always detached before the old contents are released
+	inline aeon & operator = (aeon const & other) { aeon tmp { other }; return *this = std::move(tmp); }
+	inline aeon & operator = (aeon && other) noexcept {
+		if (this == &other) return *this;
+		aeon tmp { std::move(other) };
+		reset();
+		take(tmp);
+		return *this;
+	}
 	
 	template <typename T, std::enable_if_t<std::is_same<T, bool>::value, int> = 0>
-	inline aeon & operator = (bool const & v) { boolean() = v; return *this; }
-	template <typename T, std::enable_if_t<std::is_integral<T>::value, int> = 0>
+	inline aeon & operator = (T const & v) { boolean() = v; return *this; }
+	template <typename T, std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value, int> = 0>
 	inline aeon & operator = (T const & v) { integer() = static_cast<int_t>(v); return *this; }
 	template <typename T, std::enable_if_t<std::is_floating_point<T>::value, int> = 0>
 	inline aeon & operator = (T const & v) { floating() = static_cast<flt_t>(v); return *this; }
 	inline aeon & operator = (str_t const & v) { string() = v; return *this; }
+	inline aeon & operator = (char const * v) { string() = v; return *this; }
 	
 	[[nodiscard]] aeon & operator [] (size_t);
 	[[nodiscard]] aeon const & operator[] (size_t) const;
 	
 	[[nodiscard]] aeon & operator [] (str_t const &);
 	[[nodiscard]] aeon const & operator [] (str_t const &) const;
+	[[nodiscard]] aeon & operator [] (key_t const &);
+	[[nodiscard]] aeon const & operator [] (key_t const &) const;
+	[[nodiscard]] aeon const & operator [] (path const &) const; // first match, or null
 	
-	[[nodiscard]] bool operator == (aeon const & other) const { return *value == *other.value; }
+	[[nodiscard]] bool operator == (aeon const & other) const;
 	
 	template <typename T, std::enable_if_t<std::is_same<T, bool>::value, int> = 0>
-	[[nodiscard]] bool operator == (bool const & v) const { return is_bool() ? v == get<bool>() : false; }
-	template <typename T, std::enable_if_t<std::is_integral<T>::value, int> = 0>
+	[[nodiscard]] bool operator == (T const & v) const { return is_bool() ? v == get<bool>() : false; }
+	template <typename T, std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value, int> = 0>
 	[[nodiscard]] bool operator == (T const & v) const {
 		if (is_integer()) return static_cast<int_t>(v) == get<int_t>();
 		else if (is_floating()) return static_cast<flt_t>(v) == get<flt_t>();
@@ -169,13 +452,481 @@ public:
 		else if (is_integer()) return static_cast<flt_t>(v) == static_cast<flt_t>(get<int_t>());
 		else return false;
 	}
-	[[nodiscard]] bool operator == (str_t const & v) const { return is_string() ? v == get<str_t>() : false; }
+	[[nodiscard]] bool operator == (str_t const & v) const { return is_string() ? v == view() : false; }
+	[[nodiscard]] bool operator == (char const * v) const { return is_string() ? view() == v : false; }
 	
 private:
+	
+	struct builder;
+	struct writer;
+	struct differ;
+	struct ndjson;
+	struct lazy_index;
+	
+	// small scalars are stored in place, strings and containers are owned through a pointer
+	// external values do not own their storage: strings are views of m_len bytes and containers belong to an arena
+	// lazy containers share the index of their input, m_len being the position of their opening token, and are replaced by
+	// the parsed container on first access
+	// containers are allocated along with a slot for their hash, written by hash() and only trusted right after it
+	type_t m_type = type_t::nul;
+	bool m_external = false;
+	bool m_lazy = false;
+	uint32_t m_len = 0;
+	
+	template <typename T> struct cached {
+		T value;
+		uint64_t hash = 0;
+		template <typename ... ARGS> cached(ARGS && ... args) : value(std::forward<ARGS>(args)...) {}
+	};
+	
+	union {
+		bool m_bool;
+		int_t m_int;
+		flt_t m_flt;
+		str_t * m_str;
+		char const * m_view;
+		cached<ary_t> * m_ary;
+		cached<map_t> * m_map;
+		lazy_index * m_index;
+	};
+	
+	// types from string onward own out-of-line storage
+	void release();
+	inline void reset() {
+		if (m_type >= type_t::string && (!m_external || m_lazy)) release();
+		m_type = type_t::nul;
+		m_external = false;
+		m_lazy = false;
+	}
+	
+	inline void take(aeon & other) noexcept {
+		m_type = other.m_type;
+		m_external = other.m_external;
+		m_lazy = other.m_lazy;
+		m_len = other.m_len;
+		m_int = other.m_int;
+		other.m_type = type_t::nul;
+		other.m_external = false;
+		other.m_lazy = false;
+	}
+	
+	void materialize() const;
+	
+	// the hash recorded by the last hash() of this container or one above it, computed for scalars
+	[[nodiscard]] uint64_t cached_hash() const;
+	
+	[[nodiscard]] inline std::string_view view() const { return m_external ? std::string_view { m_view, m_len } : std::string_view { *m_str }; }
+	
+	template <typename T> static constexpr type_t type_of() {
+		if constexpr (std::is_same_v<T, nul_t>) return type_t::nul;
+		else if constexpr (std::is_same_v<T, bool>) return type_t::boolean;
+		else if constexpr (std::is_same_v<T, int_t>) return type_t::integer;
+		else if constexpr (std::is_same_v<T, flt_t>) return type_t::floating;
+		else if constexpr (std::is_same_v<T, str_t>) return type_t::string;
+		else if constexpr (std::is_same_v<T, ary_t>) return type_t::array;
+		else if constexpr (std::is_same_v<T, map_t>) return type_t::map;
+	}
+	
 	template <typename T>
-	[[nodiscard]] inline bool holds() const { return std::holds_alternative<T>(*value); }
+	[[nodiscard]] inline bool holds() const { return m_type == type_of<T>(); }
 	template <typename T>
-	[[nodiscard]] inline T & get() { return std::get<T>(*value); }
+	[[nodiscard]] inline T & get() {
+		if constexpr (std::is_same_v<T, bool>) return m_bool;
+		else if constexpr (std::is_same_v<T, int_t>) return m_int;
+		else if constexpr (std::is_same_v<T, flt_t>) return m_flt;
+		else if constexpr (std::is_same_v<T, str_t>) return *m_str;
+		else if constexpr (std::is_same_v<T, ary_t>) {
+			if (m_lazy) materialize();
+			return m_ary->value;
+		}
+		else if constexpr (std::is_same_v<T, map_t>) {
+			if (m_lazy) materialize();
+			return m_map->value;
+		}
+	}
 	template <typename T>
-	[[nodiscard]] inline T const & get() const { return std::get<T>(*value); }
+	[[nodiscard]] inline T const & get() const { return const_cast<aeon *>(this)->get<T>(); }
+	
+	// replaces the current value with a default constructed T
+	template <typename T> T & emplace() {
+		reset();
+		m_type = type_of<T>();
+		if constexpr (std::is_same_v<T, str_t>) m_str = new str_t;
+		else if constexpr (std::is_same_v<T, ary_t>) m_ary = new cached<ary_t>;
+		else if constexpr (std::is_same_v<T, map_t>) m_map = new cached<map_t>;
+		else m_int = 0;
+		return get<T>();
+	}
+	
+	template <typename F> decltype(auto) visit(F && f) const {
+		switch (m_type) {
+			default:
+			case type_t::nul: return f(nul_t {});
+			case type_t::boolean: return f(m_bool);
+			case type_t::integer: return f(m_int);
+			case type_t::floating: return f(m_flt);
+			case type_t::string: return f(view());
+			case type_t::array: return f(get<ary_t>());
+			case type_t::map: return f(get<map_t>());
+		}
+	}
+};
+
+struct meadow::aeon::format final {
+	unsigned indent = 0;    // spaces per level, 0 keeps everything on one line
+	bool canonical = false;
+	bool ascii = false;     // \uXXXX escapes (surrogate pairs beyond the BMP), invalid UTF-8 becomes U+FFFD
+};
+
+struct meadow::aeon::document final {
+	
+	document();
+	document(document &&) = default;
+	document & operator = (document &&) = default;
+	
+	[[nodiscard]] inline aeon const & root() const { return m_root; }
+	[[nodiscard]] inline aeon const * operator -> () const { return &m_root; }
+	[[nodiscard]] inline aeon const & operator * () const { return m_root; }
+	
+	// Drops the tree and releases the arena.
+	void clear();
+	
+private:
+	friend struct aeon::builder;
+	
+	std::unique_ptr<std::pmr::monotonic_buffer_resource> m_arena;
+	aeon m_root;
+};
+
+struct meadow::aeon::limits final {
+	size_t max_input = 64 << 20; // bytes
+	size_t max_depth = 512;      // nested arrays and maps
+	size_t max_string = 1 << 20; // bytes of a string or key as written, escapes included
+	size_t max_number = 64;      // characters of a number
+	size_t max_nodes = 1 << 22;  // values of any type, containers included
+};
+
+struct meadow::aeon::reader final {
+	
+	reader(char const * begin, char const * end);
+	inline reader(std::string_view str) : reader(str.data(), str.data() + str.size()) {}
+	
+	// A strict reader, as for deserialize_json with limits. Values are checked as they are read, so a prefix of the events
+	// may be delivered before the input is rejected.
+	reader(char const * begin, char const * end, limits const &);
+	inline reader(std::string_view str, limits const & lim) : reader(str.data(), str.data() + str.size(), lim) {}
+	
+	// Advances to the next event, returns false once the value has been read in full.
+	bool next();
+	
+	// After a start_array or start_map event, jumps past the matching end without reporting or validating the contents.
+	// The next event is whatever follows the container. Has no effect after any other event.
+	void skip();
+	
+	[[nodiscard]] inline event_t event() const { return m_event; }
+	[[nodiscard]] inline size_t depth() const { return m_stack.size(); }
+	
+	[[nodiscard]] inline bool boolean() const { return m_bool; }
+	[[nodiscard]] inline int_t integer() const { return m_int; }
+	[[nodiscard]] inline flt_t floating() const { return m_flt; }
+	[[nodiscard]] inline std::string_view string() const { return m_str; }
+	
+	// Whether string() refers directly to the input, as opposed to an unescaped copy held by the reader.
+	[[nodiscard]] inline bool borrowed() const { return m_borrowed; }
+	
+	// The last token read from the input: the bracket of a start or end event (including the end reached by skip), or the
+	// closing quote of a string.
+	[[nodiscard]] inline char const * position() const { return m_tokens[m_pos - 1]; }
+	
+private:
+	
+	enum class frame_t : uint8_t {
+		array,
+		map_key,
+		map_value,
+	};
+	
+	char const * m_end;
+	char const * m_first_control;
+	std::vector<char const *> m_tokens;
+	size_t m_pos = 0;
+	std::vector<frame_t> m_stack;
+	bool m_started = false;
+	
+	bool m_strict = false;
+	bool m_whole = false;  // nothing may follow the value, as when strict
+	bool m_convert = true; // numbers are only checked, not converted, when validating
+	limits m_limits {};
+	size_t m_nodes = 0;
+	
+	event_t m_event = event_t::none;
+	bool m_bool = false;
+	bool m_borrowed = false;
+	int_t m_int = 0;
+	flt_t m_flt = 0;
+	std::string_view m_str;
+	str_t m_scratch;
+	
+	friend aeon;
+	
+	// reads tokens already found, those of one level of a lazily parsed input
+	reader(std::vector<char const *> && tokens, char const * end, char const * first_control);
+	
+	char const * next_token();
+	char const * next_relevant();
+	char const * next_strict();
+	void push(frame_t);
+	void check_scalar_end(char const *) const;
+	void read_string(char const *);
+	void read_literal(char const *, std::string_view);
+	void read_numerical(char const *);
+};
+
+struct meadow::aeon::handler {
+	virtual ~handler() = default;
+	
+	virtual void null() {}
+	virtual void boolean(bool) {}
+	virtual void integer(int_t) {}
+	virtual void floating(flt_t) {}
+	virtual void string(std::string_view) {}
+	virtual void key(std::string_view) {}
+	virtual void start_array() {}
+	virtual void end_array() {}
+	virtual void start_map() {}
+	virtual void end_map() {}
+};
+
+struct meadow::aeon::parser final {
+	
+	// Consumes a piece of input and returns the number of top-level values it completed. Invalid input throws
+	// deserialize_exception, discarding the offending value along with the remainder of the piece. Values completed
+	// earlier in the piece remain available and the parser can continue with the next feed.
+	size_t feed(char const * data, size_t size);
+	inline size_t feed(std::string_view str) { return feed(str.data(), str.size()); }
+	
+	// Marks the end of input, completing a trailing top-level number or literal which could otherwise still be continued
+	// by the next feed. Throws deserialize_exception if a value is left incomplete or invalid, discarding it, while values
+	// completed before it remain available.
+	void finish();
+	
+	[[nodiscard]] inline bool empty() const { return m_values.empty(); }
+	[[nodiscard]] inline size_t size() const { return m_values.size(); }
+	
+	// Removes and returns the oldest completed value.
+	aeon pop();
+	
+	// Number of bytes held for the value currently in progress.
+	[[nodiscard]] inline size_t pending() const { return m_pending.size(); }
+	
+	// Discards the value in progress and every completed value.
+	void clear();
+	
+private:
+	
+	enum class state_t : uint8_t {
+		between,  // outside any value
+		scalar,   // within a top-level number or literal
+		string,   // within a string, not following a backslash
+		escape,   // within a string, following a backslash
+		container // within a container, outside strings
+	};
+	
+	std::deque<aeon> m_values;
+	str_t m_pending;
+	size_t m_depth = 0;
+	state_t m_state = state_t::between;
+	
+	void complete(char const * begin, char const * end);
+	void abandon();
+};
+
+struct meadow::aeon::key_pool final {
+	
+	key_pool();
+	~key_pool();
+	key_pool(key_pool const &) = delete;
+	key_pool & operator = (key_pool const &) = delete;
+	
+	// Returns the pool's handle for the key, adding it if new. Recently used keys are found in a per-thread cache
+	// without taking any lock.
+	[[nodiscard]] key_t intern(std::string_view);
+	
+	[[nodiscard]] size_t size() const;
+	
+	// While a scope is alive, new map keys inserted on its thread by parsing or by operator [] are interned in the pool.
+	// Scopes nest, the innermost one applies.
+	struct scope final {
+		scope(key_pool &);
+		~scope();
+		scope(scope const &) = delete;
+		scope & operator = (scope const &) = delete;
+	private:
+		key_pool * m_previous;
+	};
+	
+	// the pool installed on this thread, if any
+	[[nodiscard]] static key_pool * current();
+	
+private:
+	
+	static constexpr size_t SHARD_COUNT = 16;
+	struct shard;
+	
+	uint64_t m_id;
+	std::unique_ptr<shard []> m_shards;
+};
+
+struct meadow::aeon::emitter final {
+	
+	emitter(sink_fn, void * ctx);
+	emitter(std::string & out);
+	emitter(buffer &);
+	~emitter(); // flushes, any error from the sink is lost
+	emitter(emitter const &) = delete;
+	emitter & operator = (emitter const &) = delete;
+	
+	void null();
+	void boolean(bool);
+	void integer(int_t);
+	void floating(flt_t);
+	void string(std::string_view);
+	void key(std::string_view);
+	void start_array();
+	void end_array();
+	void start_map();
+	void end_map();
+	
+	// writes an entire tree as a single value
+	void value(aeon const &);
+	
+	// output is buffered until flushed
+	void flush();
+	
+private:
+	std::unique_ptr<writer> m_writer;
+	bool m_comma = false;
+	
+	void separate();
+};
+
+struct meadow::aeon::path final {
+	
+	// throws std::invalid_argument for anything but "" (the whole value) or a sequence of "/" prefixed segments
+	path(std::string_view pointer);
+	
+	[[nodiscard]] inline size_t size() const { return m_segments.size(); }
+	[[nodiscard]] inline bool wildcard() const { return m_wildcard; }
+	
+	// the first match in document order, or nullptr
+	[[nodiscard]] aeon const * find(aeon const & root) const;
+	
+	// Batch form, results[i] is the first match within docs[i]. Every document is advanced one segment at a time, which keeps
+	// the segment in cache and lets the next node of each document be prefetched while the others are resolved.
+	void find(aeon const * docs, size_t count, aeon const ** results) const;
+	
+	// every match, in document order
+	template <typename F> void for_each(aeon const & root, F && fn) const { visit(root, 0, fn); }
+	
+	// Evaluates the path while parsing, building only the matched values. Subtrees off the path are skipped without being
+	// parsed or validated, and without wildcards parsing stops at the first match. Invalid input along the way throws
+	// deserialize_exception.
+	void select_json(std::string_view json, record_fn const & fn) const;
+	
+private:
+	
+	struct segment {
+		key_t key;    // refers to m_text
+		size_t index; // npos unless the segment is an array index
+		bool any;
+	};
+	
+	std::shared_ptr<std::string const> m_text; // unescaped segments, shared by copies so that keys stay valid
+	std::vector<segment> m_segments;
+	bool m_wildcard = false;
+	
+	static aeon const * step(aeon const & v, segment const & s);
+	aeon const * first(aeon const & v, size_t depth) const;
+	bool select(reader & r, size_t depth, record_fn const & fn) const;
+	
+	template <typename F> void visit(aeon const & v, size_t depth, F & fn) const {
+		if (depth == m_segments.size()) {
+			fn(v);
+			return;
+		}
+		segment const & s = m_segments[depth];
+		if (!s.any) {
+			if (aeon const * next = step(v, s)) visit(*next, depth + 1, fn);
+		} else if (v.is_array()) {
+			for (aeon const & e : v.array()) visit(e, depth + 1, fn);
+		} else if (v.is_map()) {
+			for (auto const & [key, e] : v.map()) visit(e, depth + 1, fn);
+		}
+	}
+};
+
+template <> struct std::hash<meadow::aeon> {
+	inline size_t operator () (meadow::aeon const & v) const { return v.hash(); }
+};
+
+struct meadow::aeon::frozen final {
+	
+	struct value;
+	
+	// Views an image held in memory, which must outlive the view and every value taken from it. Only the header is checked
+	// up front (throwing deserialize_exception), the rest is bounds checked as it is accessed.
+	frozen(std::string_view image);
+	
+	// Maps the file read-only for as long as the view or any copy of it exists. Pages are only read once accessed and are
+	// shared with every other process mapping the same file. Failure to open or map it throws std::system_error.
+	[[nodiscard]] static frozen open(char const * path);
+	
+	[[nodiscard]] value root() const;
+	
+private:
+	std::shared_ptr<void const> m_mapping;
+	std::string_view m_image;
+};
+
+// A handle to one value of a frozen image, valid as long as the image.
+struct meadow::aeon::frozen::value final {
+	
+	[[nodiscard]] type_t type() const;
+	[[nodiscard]] size_t size() const;
+	
+	[[nodiscard]] inline bool is_null()     const { return type() == type_t::nul; }
+	[[nodiscard]] inline bool is_bool()     const { return type() == type_t::boolean; }
+	[[nodiscard]] inline bool is_integer()  const { return type() == type_t::integer; }
+	[[nodiscard]] inline bool is_floating() const { return type() == type_t::floating; }
+	[[nodiscard]] inline bool is_string()   const { return type() == type_t::string; }
+	[[nodiscard]] inline bool is_array()    const { return type() == type_t::array; }
+	[[nodiscard]] inline bool is_map()      const { return type() == type_t::map; }
+	
+	// type mismatches produce default values, as with a const aeon
+	[[nodiscard]] bool boolean() const;
+	[[nodiscard]] int_t integer() const;
+	[[nodiscard]] flt_t floating() const;
+	[[nodiscard]] std::string_view string() const;
+	
+	// out of range indices and missing keys produce null
+	[[nodiscard]] value operator [] (size_t) const;
+	[[nodiscard]] value operator [] (std::string_view) const;
+	[[nodiscard]] bool contains(std::string_view) const;
+	
+	// the map entry at the given position in key order
+	[[nodiscard]] std::pair<std::string_view, value> entry(size_t) const;
+	
+	// copies the value into an ordinary, independently owned tree, throwing deserialize_exception for a corrupt image
+	[[nodiscard]] aeon thaw() const;
+	
+private:
+	friend struct frozen;
+	
+	std::string_view m_image;
+	char const * m_slot;
+	
+	inline value(std::string_view image, char const * slot) : m_image(image), m_slot(slot) {}
+	
+	char const * block(uint64_t offset, size_t bytes) const;
+	aeon thaw(size_t depth) const;
 };
@@ -0,0 +1,399 @@
+#pragma once
+
+/*
+██╗  ██╗███████╗ █████╗ ██████╗ ███████╗██████╗      ██████╗ ███╗   ██╗██╗  ██╗   ██╗
+██║  ██║██╔════╝██╔══██╗██╔══██╗██╔════╝██╔══██╗    ██╔═══██╗████╗  ██║██║  ╚██╗ ██╔╝
+███████║█████╗  ███████║██║  ██║█████╗  ██████╔╝    ██║   ██║██╔██╗ ██║██║   ╚████╔╝
+██╔══██║██╔══╝  ██╔══██║██║  ██║██╔══╝  ██╔══██╗    ██║   ██║██║╚██╗██║██║    ╚██╔╝
+██║  ██║███████╗██║  ██║██████╔╝███████╗██║  ██║    ╚██████╔╝██║ ╚████║███████╗██║
+╚═╝  ╚═╝╚══════╝╚═╝  ╚═╝╚═════╝ ╚══════╝╚═╝  ╚═╝     ╚═════╝ ╚═╝  ╚═══╝╚══════╝╚═╝
+*/
+
+#include <array>
+#include <bit>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "aeon.hh"
+
+// Binds JSON directly to C++ types through aeon::reader and aeon::emitter, without an intermediate tree. Supported are bool,
+// integers, floating point, std::string, std::optional (null, or omitted from output when empty), std::vector, std::map and
+// std::unordered_map with string keys, aeon itself for untyped subtrees, and structs with a descriptor.
+//
+// A descriptor lists the bound members of a struct along with their keys. MEADOW_AEON_BIND declares one at global scope
+// using the member names as keys, up to 32 of them:
+//
+//     struct point { int x; int y; std::optional<std::string> label; };
+//     MEADOW_AEON_BIND(point, x, y, label)
+//
+// or it can be written out for different keys:
+//
+//     template <> struct meadow::binding::descriptor<point> {
+//         static constexpr auto fields = std::make_tuple(binding::field { "X", &point::x }, binding::field { "Y", &point::y });
+//     };
+//
+// Keys are matched through a perfect hash built at compile time, so each key costs one hash, one table lookup and one
+// comparison before dispatching straight to the member's reader. Unknown keys are skipped and members without a key in
+// the input keep their previous value. Any other mismatch between input and type throws aeon::deserialize_exception.
+
+namespace meadow::binding {
+	
+	template <typename T> struct descriptor;
+	
+	template <typename T, typename M>
+	struct field {
+		std::string_view name;
+		M T::* member;
+	};
+	
+	template <typename T, typename M> field(std::string_view, M T::*) -> field<T, M>;
+	
+	template <typename T> void read(T & out, aeon::reader & r);
+	template <typename T> void write(aeon::emitter & e, T const & value);
+}
+
+// ================================================================
+// DETAIL
+// ================================================================
+
+namespace meadow::binding::detail {
+	
+	template <typename T> struct is_optional : std::false_type {};
+	template <typename T> struct is_optional<std::optional<T>> : std::true_type {};
+	
+	template <typename T> struct is_vector : std::false_type {};
+	template <typename T, typename A> struct is_vector<std::vector<T, A>> : std::true_type {};
+	
+	template <typename T> struct is_string_map : std::false_type {};
+	template <typename V, typename C, typename A> struct is_string_map<std::map<std::string, V, C, A>> : std::true_type {};
+	template <typename V, typename H, typename E, typename A> struct is_string_map<std::unordered_map<std::string, V, H, E, A>> : std::true_type {};
+	
+	template <typename T, typename = void> struct is_bound : std::false_type {};
+	template <typename T> struct is_bound<T, std::void_t<decltype(descriptor<T>::fields)>> : std::true_type {};
+	
+	template <typename T> inline constexpr bool dependent_false = false;
+	
+	[[noreturn]] inline void mismatch() {
+		throw aeon::deserialize_exception {"type mismatch"};
+	}
+	
+	inline void expect(aeon::reader const & r, aeon::event_t event) {
+		if (r.event() != event) mismatch();
+	}
+	
+	// ----------------
+	// KEY LOOKUP
+	// ----------------
+	
+	constexpr uint32_t key_hash(std::string_view key, uint32_t seed) {
+		uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+		for (char c : key) {
+			h ^= static_cast<uint8_t>(c);
+			h *= 16777619u;
+		}
+		return h ^ (h >> 16);
+	}
+	
+	// Slots hold the field index + 1, zero when empty. The table is the smallest power of two, no smaller than the field
+	// count, for which one of the first SEEDS seeds places every key in its own slot.
+	template <size_t N>
+	struct key_table {
+		static_assert(N > 0 && N < 256);
+		static constexpr size_t CAPACITY = std::bit_ceil(N) * 8;
+		static constexpr uint32_t SEEDS = 256;
+		
+		uint32_t seed = 0;
+		uint32_t mask = 0;
+		std::array<uint8_t, CAPACITY> slots {};
+	};
+	
+	template <size_t N>
+	constexpr key_table<N> make_key_table(std::array<std::string_view, N> const & names) {
+		key_table<N> table;
+		for (size_t size = std::bit_ceil(N); size <= table.CAPACITY; size *= 2) {
+			for (uint32_t seed = 0; seed < table.SEEDS; seed++) {
+				table.slots = {};
+				bool placed = true;
+				for (size_t i = 0; i < N && placed; i++) {
+					uint8_t & slot = table.slots[key_hash(names[i], seed) & (size - 1)];
+					if (slot) placed = false;
+					else slot = static_cast<uint8_t>(i + 1);
+				}
+				if (placed) {
+					table.seed = seed;
+					table.mask = static_cast<uint32_t>(size - 1);
+					return table;
+				}
+			}
+		}
+		throw std::logic_error {"binding: duplicate field names"}; // not a constant expression, fails the build
+	}
+	
+	template <typename T>
+	inline constexpr size_t field_count = std::tuple_size_v<std::remove_cvref_t<decltype(descriptor<T>::fields)>>;
+	
+	template <typename T>
+	inline constexpr auto field_names = []<size_t ... I>(std::index_sequence<I ...>) {
+		return std::array<std::string_view, sizeof...(I)> { std::get<I>(descriptor<T>::fields).name ... };
+	}(std::make_index_sequence<field_count<T>> {});
+	
+	template <typename T>
+	inline constexpr auto field_table = make_key_table(field_names<T>);
+	
+	// index of the field bound to key, or -1
+	template <typename T>
+	inline int find_field(std::string_view key) {
+		constexpr auto const & table = field_table<T>;
+		uint8_t slot = table.slots[key_hash(key, table.seed) & table.mask];
+		if (!slot || field_names<T>[slot - 1] != key) return -1;
+		return slot - 1;
+	}
+	
+	// ----------------
+	// STRUCTS
+	// ----------------
+	
+	template <typename T, size_t I>
+	void read_field(T & out, aeon::reader & r) {
+		read(out.*(std::get<I>(descriptor<T>::fields).member), r);
+	}
+	
+	template <typename T>
+	inline constexpr auto field_readers = []<size_t ... I>(std::index_sequence<I ...>) {
+		return std::array<void (*)(T &, aeon::reader &), sizeof...(I)> { &read_field<T, I> ... };
+	}(std::make_index_sequence<field_count<T>> {});
+	
+	template <typename T>
+	void read_struct(T & out, aeon::reader & r) {
+		expect(r, aeon::event_t::start_map);
+		while (r.next() && r.event() == aeon::event_t::key) {
+			int i = find_field<T>(r.string());
+			r.next();
+			if (i < 0) r.skip();
+			else field_readers<T>[i](out, r);
+		}
+	}
+	
+	template <typename T>
+	void write_struct(aeon::emitter & e, T const & value) {
+		e.start_map();
+		std::apply([&](auto const & ... fields) {
+			auto write_field = [&](auto const & field) {
+				auto const & member = value.*(field.member);
+				if constexpr (is_optional<std::remove_cvref_t<decltype(member)>>::value) if (!member) return;
+				e.key(field.name);
+				write(e, member);
+			};
+			(write_field(fields), ...);
+		}, descriptor<T>::fields);
+		e.end_map();
+	}
+	
+	// ----------------
+	// TREES
+	// ----------------
+	
+	inline void read_tree(aeon & out, aeon::reader & r) {
+		switch (r.event()) {
+			case aeon::event_t::null: out = aeon {}; return;
+			case aeon::event_t::boolean: out = r.boolean(); return;
+			case aeon::event_t::integer: out = r.integer(); return;
+			case aeon::event_t::floating: out = r.floating(); return;
+			case aeon::event_t::string: out = r.string(); return;
+			case aeon::event_t::start_array: {
+				aeon::ary_t & ary = out.array();
+				ary.clear();
+				while (r.next() && r.event() != aeon::event_t::end_array) read_tree(ary.emplace_back(), r);
+				return;
+			}
+			case aeon::event_t::start_map: {
+				aeon::map_t & map = out.map();
+				map.clear();
+				while (r.next() && r.event() == aeon::event_t::key) {
+					aeon & slot = map[r.string()];
+					r.next();
+					read_tree(slot, r);
+				}
+				return;
+			}
+			default: mismatch();
+		}
+	}
+}
+
+// ================================================================
+// READ AND WRITE
+// ================================================================
+
+// Reads a value whose first event is the current event of the reader, leaving the reader at its last event.
+template <typename T>
+void meadow::binding::read(T & out, aeon::reader & r) {
+	using event_t = aeon::event_t;
+	
+	if constexpr (std::is_same_v<T, bool>) {
+		detail::expect(r, event_t::boolean);
+		out = r.boolean();
+	} else if constexpr (std::is_integral_v<T>) {
+		detail::expect(r, event_t::integer);
+		if (!std::in_range<T>(r.integer())) detail::mismatch();
+		out = static_cast<T>(r.integer());
+	} else if constexpr (std::is_floating_point_v<T>) {
+		if (r.event() == event_t::floating) out = static_cast<T>(r.floating());
+		else if (r.event() == event_t::integer) out = static_cast<T>(r.integer());
+		else detail::mismatch();
+	} else if constexpr (std::is_same_v<T, std::string>) {
+		detail::expect(r, event_t::string);
+		out.assign(r.string());
+	} else if constexpr (detail::is_optional<T>::value) {
+		if (r.event() == event_t::null) out.reset();
+		else read(out.emplace(), r);
+	} else if constexpr (detail::is_vector<T>::value) {
+		detail::expect(r, event_t::start_array);
+		out.clear();
+		while (r.next() && r.event() != event_t::end_array) read(out.emplace_back(), r);
+	} else if constexpr (detail::is_string_map<T>::value) {
+		detail::expect(r, event_t::start_map);
+		out.clear();
+		while (r.next() && r.event() == event_t::key) {
+			auto & slot = out[std::string { r.string() }];
+			r.next();
+			read(slot, r);
+		}
+	} else if constexpr (std::is_same_v<T, aeon>) {
+		detail::read_tree(out, r);
+	} else if constexpr (detail::is_bound<T>::value) {
+		detail::read_struct(out, r);
+	} else {
+		static_assert(detail::dependent_false<T>, "binding: type has no descriptor");
+	}
+}
+
+template <typename T>
+void meadow::binding::write(aeon::emitter & e, T const & value) {
+	if constexpr (std::is_same_v<T, bool>) {
+		e.boolean(value);
+	} else if constexpr (std::is_integral_v<T>) {
+		e.integer(static_cast<aeon::int_t>(value));
+	} else if constexpr (std::is_floating_point_v<T>) {
+		e.floating(static_cast<aeon::flt_t>(value));
+	} else if constexpr (std::is_convertible_v<T const &, std::string_view>) {
+		e.string(value);
+	} else if constexpr (detail::is_optional<T>::value) {
+		if (value) write(e, *value);
+		else e.null();
+	} else if constexpr (detail::is_vector<T>::value) {
+		e.start_array();
+		for (auto const & element : value) write(e, element);
+		e.end_array();
+	} else if constexpr (detail::is_string_map<T>::value) {
+		e.start_map();
+		for (auto const & [key, element] : value) {
+			e.key(key);
+			write(e, element);
+		}
+		e.end_map();
+	} else if constexpr (std::is_same_v<T, aeon>) {
+		e.value(value);
+	} else if constexpr (detail::is_bound<T>::value) {
+		detail::write_struct(e, value);
+	} else {
+		static_assert(detail::dependent_false<T>, "binding: type has no descriptor");
+	}
+}
+
+// ================================================================
+// SERIALIZATION
+// ================================================================
+
+namespace meadow::binding {
+	
+	template <typename T>
+	void deserialize_json(std::string_view str, T & out) {
+		aeon::reader r { str };
+		if (!r.next()) throw aeon::deserialize_exception {"unexpected end of input"};
+		read(out, r);
+	}
+	
+	template <typename T>
+	[[nodiscard]] T deserialize_json(std::string_view str) {
+		T out {};
+		deserialize_json(str, out);
+		return out;
+	}
+	
+	template <typename T>
+	void serialize_json(T const & value, aeon::emitter & e) {
+		write(e, value);
+	}
+	
+	template <typename T>
+	[[nodiscard]] std::string serialize_json(T const & value) {
+		std::string out;
+		aeon::emitter e { out };
+		write(e, value);
+		e.flush();
+		return out;
+	}
+	
+	template <typename T>
+	void serialize_json(T const & value, buffer & buf) {
+		aeon::emitter e { buf };
+		write(e, value);
+		e.flush();
+	}
+}
+
+// ================================================================
+// DESCRIPTOR MACRO
+// ================================================================
+
+#define MEADOW_AEON_FIELD_(TYPE, NAME) ::meadow::binding::field<TYPE, decltype(TYPE::NAME)> { #NAME, &TYPE::NAME }
+#define MEADOW_AEON_FIELDS_1(TYPE, NAME) MEADOW_AEON_FIELD_(TYPE, NAME)
+#define MEADOW_AEON_FIELDS_2(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_1(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_3(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_2(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_4(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_3(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_5(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_4(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_6(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_5(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_7(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_6(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_8(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_7(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_9(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_8(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_10(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_9(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_11(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_10(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_12(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_11(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_13(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_12(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_14(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_13(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_15(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_14(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_16(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_15(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_17(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_16(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_18(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_17(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_19(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_18(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_20(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_19(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_21(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_20(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_22(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_21(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_23(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_22(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_24(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_23(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_25(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_24(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_26(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_25(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_27(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_26(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_28(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_27(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_29(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_28(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_30(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_29(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_31(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_30(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_FIELDS_32(TYPE, NAME, ...) MEADOW_AEON_FIELD_(TYPE, NAME), MEADOW_AEON_FIELDS_31(TYPE, __VA_ARGS__)
+#define MEADOW_AEON_COUNT_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, N, ...) N
+#define MEADOW_AEON_COUNT(...) MEADOW_AEON_COUNT_(__VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1)
+#define MEADOW_AEON_CAT_(A, B) A##B
+#define MEADOW_AEON_CAT(A, B) MEADOW_AEON_CAT_(A, B)
+
+#define MEADOW_AEON_BIND(TYPE, ...) \
+	template <> struct meadow::binding::descriptor<TYPE> { \
+		static constexpr auto fields = std::make_tuple(MEADOW_AEON_CAT(MEADOW_AEON_FIELDS_, MEADOW_AEON_COUNT(__VA_ARGS__))(TYPE, __VA_ARGS__)); \
+	};
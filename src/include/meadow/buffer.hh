@@ -4,35 +4,85 @@
 #include <cstdint>
 #include <string>
 
+#include <sys/types.h>
+
 #include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <memory_resource>
 #include <numeric>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 
 namespace meadow {
 	struct buffer;
+	template <size_t N> struct small_buffer;
 }
 
+// A byte queue: writes append at the back, reads consume from the front. Contents live in a chain of blocks. A contiguous
+// buffer (the default) only ever has one, which grows as needed, so data() and size() always describe all of its contents.
+// A segmented buffer instead starts a new block whenever the last one fills, so nothing written is ever moved again, and
+// whole blocks can be handed between buffers by transfer() without copying.
+//
+// Blocks come from the given memory resource (e.g. a thread-local pool or an arena), or from the heap by default, where a
+// contiguous buffer can grow in place with realloc. Copies always use the heap, moves keep the source's resource. A buffer
+// can also start out as a memory mapped file, see map_file().
 struct meadow::buffer final {
 	
 	using byte_t = uint8_t;
 	using iterator = byte_t *;
 	using const_iterator = byte_t const *;
 	
+	static constexpr size_t default_block_size = 1 << 14;
+	
+	enum class mapping_t : uint8_t {
+		read_only,     // never written to, anything appended moves the contents to the heap first
+		copy_on_write, // writable, changes stay private to the buffer and never reach the file
+	};
+	
+	// passed on to madvise(2) for the whole mapping
+	enum class access_t : uint8_t {
+		normal,
+		sequential,
+		random,
+		will_need,
+	};
+	
 	buffer() = default;
-	buffer(size_t initial_capacity);
+	buffer(std::pmr::memory_resource *);
+	buffer(size_t initial_capacity, std::pmr::memory_resource * = nullptr);
 	buffer(const_iterator begin, const_iterator end);
 	buffer(buffer const &);
 	buffer(buffer &&);
 	
+	// blocks are at least block_size bytes, larger writes get a block of their own size
+	[[nodiscard]] static buffer segmented(size_t block_size = default_block_size, std::pmr::memory_resource * = nullptr);
+	
+	// A contiguous buffer holding the contents of a file, mapped rather than read: pages are only loaded as they are
+	// touched, and are shared through the page cache with every other process mapping the same file. A read-only buffer must
+	// not be modified through data() or [], appending to it copies the contents to the heap. A copy-on-write buffer grows
+	// by extending or moving the mapping with mremap(2), never by copying it (except where mremap is unavailable). Failure
+	// to open or map the file throws std::system_error, an empty file gives an empty buffer.
+	[[nodiscard]] static buffer map_file(char const * path, mapping_t = mapping_t::read_only, access_t = access_t::normal);
+	
 	~buffer();
 	
 	// ================================================================
 	// GENERAL
 	// ================================================================
 	
-	[[nodiscard]] inline byte_t * data() { return m_offs; }
-	[[nodiscard]] inline byte_t const * data() const { return m_offs; }
+	// the first readable byte, only the first block's worth of contents follow it if the buffer is segmented
+	[[nodiscard]] inline byte_t * data() { return m_head ? m_head->data + m_head->begin : nullptr; }
+	[[nodiscard]] inline byte_t const * data() const { return m_head ? m_head->data + m_head->begin : nullptr; }
 	[[nodiscard]] inline size_t size() const { return m_size; }
-	[[nodiscard]] inline size_t capacity() const { return m_resv; }
+	[[nodiscard]] size_t capacity() const;
+	
+	[[nodiscard]] inline bool is_segmented() const { return m_block_size; }
+	[[nodiscard]] inline std::pmr::memory_resource * resource() const { return m_resource; }
+	[[nodiscard]] inline bool is_mapped() const { return m_head && m_head->mapped; } // whether the front is a mapped file
 	
 	[[nodiscard]] std::string hex(bool lowercase = false) const;
 	
@@ -45,6 +95,9 @@ struct meadow::buffer final {
 	void resize(size_t);
 	void shrink_to_fit();
 	
+	// moves all contents of a segmented buffer into a single block, after which data() covers all of it
+	void linearize();
+	
 	// ================================================================
 	// IO
 	// ================================================================
@@ -53,31 +106,312 @@ struct meadow::buffer final {
 	template <typename T, std::enable_if_t<std::is_standard_layout_v<T>, int> = 0>
 	void write(T const & v) { write(reinterpret_cast<byte_t const *>(&v), sizeof(T)); }
 	
+	// the contiguous run of contents at the front, all of them unless the buffer is segmented
+	[[nodiscard]] std::span<byte_t const> peek() const;
+	
+	// copies up to cnt bytes from the front, read() also consumes them, returns the number of bytes copied
+	size_t peek(byte_t * dst, size_t cnt) const;
+	size_t read(byte_t * dst, size_t cnt);
+	
+	// discards up to cnt bytes from the front, returns the number of bytes discarded
+	size_t consume(size_t cnt);
+	
+	// Moves up to cnt bytes from the front of this buffer to the back of dest, returns the number of bytes moved. Whole blocks
+	// are relinked rather than copied whenever dest is segmented, or is empty and receives everything in a single block, as
+	// long as both buffers use the same resource and the block isn't a small buffer's own storage.
 	size_t transfer(buffer & dest, size_t cnt = std::numeric_limits<size_t>::max());
 	
+	// ================================================================
+	// DESCRIPTOR IO
+	// ================================================================
+	
+	// These return what the underlying system calls do: the number of bytes moved, 0 at the end of input, or -1 with errno
+	// set (EAGAIN included, for non-blocking descriptors). Interrupted calls are retried.
+	
+	// Appends up to max bytes with a single readv(2), directly into free space at the back (a segmented buffer whose last
+	// block is full gets a new one first). Anything beyond that space is read into a stack area and appended afterwards,
+	// rather than growing ahead of time.
+	ssize_t read_from(int fd, size_t max = 1 << 16);
+	
+	// Writes and consumes up to max bytes from the front, gathering every block into a single writev(2).
+	ssize_t write_to(int fd, size_t max = std::numeric_limits<size_t>::max());
+	
+#if defined(__linux__)
+	// Moves up to cnt bytes from in to out without copying them through user space: sendfile(2) when in is a regular file
+	// (reading from its current offset), splice(2) through a pipe kept by the calling thread otherwise. The pipe is drained
+	// into out before returning, waiting for it to become writable if need be. Should writing to out fail, whatever was
+	// read for it is lost.
+	static ssize_t splice(int in, int out, size_t cnt);
+#endif
+	
+	// ================================================================
+	// BINARY CODEC
+	// ================================================================
+	
+	struct writer;
+	struct reader;
+	
 	// ================================================================
 	// OPERATORS
 	// ================================================================
 	
-	inline buffer & operator = (buffer const & other) { this->~buffer(); new (this) buffer(other); return *this; }
-	inline buffer & operator = (buffer && other) { this->~buffer(); new (this) buffer(std::move(other)); return *this; }
+	// the contents and mode are replaced, the resource (and a small buffer's storage) stay
+	buffer & operator = (buffer const & other);
+	buffer & operator = (buffer && other);
 	
 	[[nodiscard]] bool operator == (buffer const & other) const;
 	
 	template <typename T, std::enable_if_t<std::is_standard_layout_v<T>, int> = 0>
 	inline buffer & operator << (T const & v) { write<T>(v); return *this; }
 	
-	[[nodiscard]] inline byte_t & operator [] (size_t i) { return m_offs[i]; }
-	[[nodiscard]] inline byte_t const & operator [] (size_t i) const { return m_offs[i]; }
+	[[nodiscard]] inline byte_t & operator [] (size_t i) { return m_head == m_tail ? m_head->data[m_head->begin + i] : locate(i); }
+	[[nodiscard]] inline byte_t const & operator [] (size_t i) const { return m_head == m_tail ? m_head->data[m_head->begin + i] : locate(i); }
 	
 private:
-	byte_t * m_data = nullptr;
-	byte_t * m_offs = nullptr;
+	
+	template <size_t N> friend struct small_buffer;
+	
+	// header of a single allocation, immediately followed by its data, or of a mapped file, pointing to the mapping
+	struct block {
+		block * next;
+		byte_t * data;
+		size_t begin;         // first readable byte
+		size_t end;           // one past the last readable byte, where writing continues
+		size_t capacity;
+		size_t mapped = 0;    // the length mapped from a file (rounded up to pages), anything past it is anonymous memory
+		bool writable = true; // read-only blocks are never written to, nor is the space of their consumed contents reused
+	};
+	
+	// a buffer using the given storage, a block header followed by inline_capacity bytes, for blocks that fit into it
+	buffer(void * storage, size_t inline_capacity, std::pmr::memory_resource *);
+	
+	// only the last block may be empty
+	block * m_head = nullptr;
+	block * m_tail = nullptr;
 	size_t m_size = 0;
-	size_t m_resv = 0;
+	size_t m_block_size = 0;                         // non-zero when segmented
+	std::pmr::memory_resource * m_resource = nullptr; // the heap when null
+	block * m_inline = nullptr;                       // small buffer storage, in use while it is the first block
+	
+	// releases all blocks, leaving the buffer empty
+	void reset();
+	
+	block * make_block(size_t capacity);
+	void free_block(block *);
+	void release(block *);
+	bool movable(block const *, buffer const & dest) const;
+	bool remap(block *, size_t);
+	void steal(buffer &);
+	void append(buffer const &);
 	
-	void align();
 	void alloc(size_t);
-	void autoreserve(size_t);
-	void check_reserve(size_t);
+	void make_room(size_t);
+	void append_block(size_t capacity);
+	void link(block *);
+	void truncate(size_t);
+	byte_t & locate(size_t) const;
+	
+	static inline size_t room(block const * b) { return b->writable ? b->capacity - b->end : 0; }
+	
+	template <size_t N> using uint_t = std::conditional_t<N == 1, uint8_t, std::conditional_t<N == 2, uint16_t, std::conditional_t<N == 4, uint32_t, uint64_t>>>;
+	
+	// fixed width values in the given byte order, T being any arithmetic or enum type of 1, 2, 4 or 8 bytes
+	template <std::endian E, typename T> static inline void store(byte_t * dst, T v) {
+		static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>);
+		static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8, "no fixed width encoding for this size");
+		uint_t<sizeof(T)> u;
+		std::memcpy(&u, &v, sizeof(T));
+		if constexpr (E != std::endian::native) u = swap(u);
+		std::memcpy(dst, &u, sizeof(T));
+	}
+	template <std::endian E, typename T> static inline T load(byte_t const * src) {
+		static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>);
+		static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8, "no fixed width encoding for this size");
+		uint_t<sizeof(T)> u;
+		std::memcpy(&u, src, sizeof(T));
+		if constexpr (E != std::endian::native) u = swap(u);
+		T v;
+		std::memcpy(&v, &u, sizeof(T));
+		return v;
+	}
+	template <typename U> static inline U swap(U u) {
+		if constexpr (sizeof(U) == 1) return u;
+		else if constexpr (sizeof(U) == 2) return __builtin_bswap16(u);
+		else if constexpr (sizeof(U) == 4) return __builtin_bswap32(u);
+		else return __builtin_bswap64(u);
+	}
+};
+
+// Encodes values at the back of a buffer: LEB128 varints, zigzag signed varints, fixed width values in either byte order,
+// and strings or byte spans prefixed with their varint length. Values are written straight into the free space of the
+// last block, which the buffer only takes account of when the writer commits (explicitly, or when it is destroyed), so
+// the buffer must not be used otherwise in the meantime. Each value only checks that it fits that space, reserve() can
+// make room for a whole batch of them at once.
+struct meadow::buffer::writer final {
+	
+	inline writer(buffer & buf) : m_buf(buf) { refresh(); }
+	inline ~writer() { commit(); }
+	writer(writer const &) = delete;
+	writer & operator = (writer const &) = delete;
+	
+	// makes cnt bytes of room, written to without allocating
+	inline void reserve(size_t cnt) { if (static_cast<size_t>(m_end - m_cur) < cnt) [[unlikely]] grow(cnt); }
+	
+	// adds everything written so far to the buffer
+	void commit();
+	
+	template <std::endian E = std::endian::little, typename T> inline void fixed(T v) {
+		reserve(sizeof(T));
+		store<E>(m_cur, v);
+		m_cur += sizeof(T);
+	}
+	
+	inline void varint(uint64_t v) {
+		reserve(10);
+		while (v >= 0x80) {
+			*m_cur++ = static_cast<byte_t>(v | 0x80);
+			v >>= 7;
+		}
+		*m_cur++ = static_cast<byte_t>(v);
+	}
+	inline void zigzag(int64_t v) { varint((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63)); }
+	
+	// unprefixed
+	inline void raw(void const * src, size_t cnt) {
+		if (static_cast<size_t>(m_end - m_cur) < cnt) [[unlikely]] return raw_slow(src, cnt);
+		std::memcpy(m_cur, src, cnt);
+		m_cur += cnt;
+	}
+	
+	// prefixed with their varint length
+	inline void bytes(std::span<byte_t const> v) { varint(v.size()); raw(v.data(), v.size()); }
+	inline void string(std::string_view v) { varint(v.size()); raw(v.data(), v.size()); }
+	
+	// unprefixed fixed width values, copied as they are when already in the right byte order
+	template <std::endian E = std::endian::little, typename T> inline void array(std::span<T const> v) {
+		if constexpr (E == std::endian::native || sizeof(T) == 1) raw(v.data(), v.size_bytes());
+		else {
+			reserve(v.size_bytes());
+			for (T const & e : v) {
+				store<E>(m_cur, e);
+				m_cur += sizeof(T);
+			}
+		}
+	}
+	
+private:
+	buffer & m_buf;
+	block * m_block = nullptr; // the block being written to, and its free space
+	byte_t * m_cur = nullptr;
+	byte_t * m_end = nullptr;
+	
+	void refresh();
+	void grow(size_t cnt);
+	void raw_slow(void const * src, size_t cnt);
+};
+
+// Decodes values written by a writer from the front of a buffer, reading straight from its first block. What is read
+// is consumed from the buffer when the reader commits (explicitly, when it is destroyed, or to read a value spanning
+// blocks), so the buffer must not be used otherwise in the meantime. Running out of contents throws std::out_of_range, a
+// varint too long for 64 bits throws std::overflow_error, after which the position within the value that failed is
+// unspecified.
+struct meadow::buffer::reader final {
+	
+	inline reader(buffer & buf) : m_buf(buf) { refresh(); }
+	inline ~reader() { commit(); }
+	reader(reader const &) = delete;
+	reader & operator = (reader const &) = delete;
+	
+	[[nodiscard]] inline size_t remaining() const { return m_buf.m_size - (m_cur - m_start); }
+	
+	// consumes everything read so far from the buffer
+	void commit();
+	
+	template <typename T, std::endian E = std::endian::little> [[nodiscard]] inline T fixed() {
+		byte_t tmp [sizeof(T)];
+		byte_t const * src = m_cur;
+		if (static_cast<size_t>(m_end - m_cur) >= sizeof(T)) [[likely]] m_cur += sizeof(T);
+		else {
+			take(tmp, sizeof(T));
+			src = tmp;
+		}
+		return load<E, T>(src);
+	}
+	
+	[[nodiscard]] inline uint64_t varint() {
+		// anything that might be cut short by the end of the block, or run past 63 bits, is left to the slow path
+		if (m_end - m_cur >= 10) [[likely]] {
+			byte_t const * p = m_cur;
+			uint64_t v = 0;
+			for (unsigned shift = 0; shift < 63; shift += 7) {
+				byte_t b = *p++;
+				v |= static_cast<uint64_t>(b & 0x7F) << shift;
+				if (!(b & 0x80)) {
+					m_cur = p;
+					return v;
+				}
+			}
+		}
+		return varint_slow();
+	}
+	[[nodiscard]] inline int64_t zigzag() {
+		uint64_t u = varint();
+		return static_cast<int64_t>((u >> 1) ^ -(u & 1));
+	}
+	
+	inline void raw(void * dst, size_t cnt) {
+		if (static_cast<size_t>(m_end - m_cur) < cnt) [[unlikely]] return take(dst, cnt);
+		std::memcpy(dst, m_cur, cnt);
+		m_cur += cnt;
+	}
+	void skip(size_t cnt);
+	
+	// the length is checked against the remaining contents before anything is allocated for it
+	[[nodiscard]] std::vector<byte_t> bytes();
+	[[nodiscard]] std::string string();
+	
+	template <std::endian E = std::endian::little, typename T> inline void array(std::span<T> v) {
+		raw(v.data(), v.size_bytes());
+		if constexpr (E != std::endian::native && sizeof(T) > 1) for (T & e : v) e = load<E, T>(reinterpret_cast<byte_t const *>(&e));
+	}
+	
+private:
+	buffer & m_buf;
+	byte_t const * m_start = nullptr; // the contiguous run at the front, and how far into it has been read
+	byte_t const * m_cur = nullptr;
+	byte_t const * m_end = nullptr;
+	
+	void refresh();
+	void take(void * dst, size_t cnt);
+	size_t length();
+	uint64_t varint_slow();
+};
+
+// Keeps up to N bytes within itself, only allocating once contents outgrow that. It holds a buffer using its storage rather
+// than being one, and converts to a reference to it to be used anywhere a buffer can. That buffer may be copied or moved
+// from like any other, the result never refers to the small buffer's storage. Moving one copies whatever is still held
+// inline.
+template <size_t N> struct meadow::small_buffer final {
+	
+	inline small_buffer(std::pmr::memory_resource * res = nullptr) : m_buffer(m_storage, N, res) {}
+	inline small_buffer(small_buffer const & other) : small_buffer() { m_buffer = other.m_buffer; }
+	inline small_buffer(small_buffer && other) : small_buffer(other.m_buffer.resource()) { m_buffer = std::move(other.m_buffer); }
+	inline small_buffer(buffer const & other) : small_buffer() { m_buffer = other; }
+	inline small_buffer(buffer && other) : small_buffer(other.resource()) { m_buffer = std::move(other); }
+	
+	inline small_buffer & operator = (small_buffer const & other) { m_buffer = other.m_buffer; return *this; }
+	inline small_buffer & operator = (small_buffer && other) { m_buffer = std::move(other.m_buffer); return *this; }
+	inline small_buffer & operator = (buffer const & other) { m_buffer = other; return *this; }
+	inline small_buffer & operator = (buffer && other) { m_buffer = std::move(other); return *this; }
+	
+	[[nodiscard]] inline buffer & operator * () { return m_buffer; }
+	[[nodiscard]] inline buffer const & operator * () const { return m_buffer; }
+	[[nodiscard]] inline buffer * operator -> () { return &m_buffer; }
+	[[nodiscard]] inline buffer const * operator -> () const { return &m_buffer; }
+	inline operator buffer & () { return m_buffer; }
+	inline operator buffer const & () const { return m_buffer; }
+	
+private:
+	alignas(buffer::block) buffer::byte_t m_storage [sizeof(buffer::block) + N];
+	buffer m_buffer;
 };
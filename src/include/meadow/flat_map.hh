@@ -0,0 +1,325 @@
+#pragma once
+
+/*
+██╗  ██╗███████╗ █████╗ ██████╗ ███████╗██████╗      ██████╗ ███╗   ██╗██╗  ██╗   ██╗
+██║  ██║██╔════╝██╔══██╗██╔══██╗██╔════╝██╔══██╗    ██╔═══██╗████╗  ██║██║  ╚██╗ ██╔╝
+███████║█████╗  ███████║██║  ██║█████╗  ██████╔╝    ██║   ██║██╔██╗ ██║██║   ╚████╔╝
+██╔══██║██╔══╝  ██╔══██║██║  ██║██╔══╝  ██╔══██╗    ██║   ██║██║╚██╗██║██║    ╚██╔╝
+██║  ██║███████╗██║  ██║██████╔╝███████╗██║  ██║    ╚██████╔╝██║ ╚████║███████╗██║
+╚═╝  ╚═╝╚══════╝╚═╝  ╚═╝╚═════╝ ╚══════╝╚═╝  ╚═╝     ╚═════╝ ╚═╝  ╚═══╝╚══════╝╚═╝
+*/
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <memory_resource>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace meadow {
+	template <typename V> struct flat_map;
+}
+
+// An insertion ordered map from strings to V, stored as one contiguous vector of entries. Lookups scan the entries linearly
+// while the map is small and go through an open addressed index of entry positions once it grows past LINEAR_MAX. As with
+// a vector, inserting may reallocate and invalidate references to other entries.
+template <typename V>
+struct meadow::flat_map final {
+	
+	static constexpr size_t LINEAR_MAX = 16;
+	
+	// A read-only handle to the bytes of a key along with their hash. Keys are allocated from the map's memory resource,
+	// except for external keys whose storage is guaranteed by the caller to outlive the map. Interned keys are external
+	// keys owned by a pool (see aeon::key_pool), which copies of the map share rather than duplicate.
+	struct key_type {
+		
+		[[nodiscard]] inline char const * data() const { return m_data; }
+		[[nodiscard]] inline size_t size() const { return m_size & SIZE_MASK; }
+		[[nodiscard]] inline uint32_t hash() const { return m_hash; }
+		[[nodiscard]] inline std::string_view view() const { return { m_data, size() }; }
+		[[nodiscard]] inline bool interned() const { return m_size & INTERNED; }
+		inline operator std::string_view () const { return view(); }
+		
+		inline bool operator == (key_type const & other) const { return m_hash == other.m_hash && (m_data == other.m_data || view() == other.view()); }
+		inline bool operator == (std::string_view other) const { return view() == other; }
+		
+		[[nodiscard]] static inline uint32_t hash_of(std::string_view str) {
+			size_t h = std::hash<std::string_view> {} (str);
+			return static_cast<uint32_t>(h ^ (h >> 32));
+		}
+		
+		// Precomputes the hash of a key used for repeated lookups. The bytes are referenced and must outlive the handle,
+		// though inserting it still copies them into the map.
+		[[nodiscard]] static inline key_type make_external(std::string_view str) {
+			return make(str.data(), str.size(), hash_of(str), EXTERNAL);
+		}
+		
+		// For key pools, the bytes must outlive every map holding the key and the hash must come from hash_of.
+		[[nodiscard]] static inline key_type make_interned(char const * data, size_t size, uint32_t hash) {
+			return make(data, size, hash, EXTERNAL | INTERNED);
+		}
+		
+	private:
+		friend struct flat_map;
+		
+		static constexpr uint32_t EXTERNAL = 1u << 31;
+		static constexpr uint32_t INTERNED = 1u << 30;
+		static constexpr uint32_t SIZE_MASK = INTERNED - 1;
+		
+		char const * m_data;
+		uint32_t m_size;
+		uint32_t m_hash;
+		
+		inline bool external() const { return m_size & EXTERNAL; }
+		
+		static inline key_type make(char const * data, size_t size, uint32_t hash, uint32_t flags) {
+			if (size > SIZE_MASK) throw std::length_error {"flat_map key too long"};
+			key_type k;
+			k.m_data = data;
+			k.m_size = static_cast<uint32_t>(size) | flags;
+			k.m_hash = hash;
+			return k;
+		}
+	};
+	
+	using mapped_type = V;
+	using value_type = std::pair<key_type, V>;
+	using allocator_type = std::pmr::polymorphic_allocator<value_type>;
+	using iterator = typename std::pmr::vector<value_type>::iterator;
+	using const_iterator = typename std::pmr::vector<value_type>::const_iterator;
+	
+	flat_map() = default;
+	inline flat_map(allocator_type alloc) : m_entries(alloc) {}
+	inline flat_map(std::initializer_list<std::pair<std::string_view, V>> init, allocator_type alloc = {}) : m_entries(alloc) {
+		reserve(init.size());
+		for (auto const & [key, value] : init) insert_or_assign(key, value);
+	}
+	
+	// copies own their keys, apart from interned keys which are shared
+	inline flat_map(flat_map const & other, allocator_type alloc = {}) : m_entries(alloc) {
+		reserve(other.size());
+		for (auto const & [key, value] : other) emplace_new(key.interned() ? key : own_key(key.view(), key.hash()), value);
+	}
+	
+	inline flat_map(flat_map && other) noexcept : m_entries(std::move(other.m_entries)), m_index(std::exchange(other.m_index, nullptr)), m_mask(std::exchange(other.m_mask, 0)) {}
+	
+	inline flat_map & operator = (flat_map const & other) {
+		if (this == &other) return *this;
+		flat_map tmp { other, get_allocator() };
+		return *this = std::move(tmp);
+	}
+	
+	inline flat_map & operator = (flat_map && other) {
+		if (this == &other) return *this;
+		if (get_allocator() != other.get_allocator()) return *this = static_cast<flat_map const &>(other);
+		clear();
+		m_entries = std::move(other.m_entries);
+		m_index = std::exchange(other.m_index, nullptr);
+		m_mask = std::exchange(other.m_mask, 0);
+		return *this;
+	}
+	
+	inline ~flat_map() { clear(); }
+	
+	[[nodiscard]] inline allocator_type get_allocator() const { return m_entries.get_allocator(); }
+	
+	[[nodiscard]] inline size_t size() const { return m_entries.size(); }
+	[[nodiscard]] inline bool empty() const { return m_entries.empty(); }
+	inline void reserve(size_t n) { m_entries.reserve(n); }
+	
+	[[nodiscard]] inline iterator begin() { return m_entries.begin(); }
+	[[nodiscard]] inline iterator end() { return m_entries.end(); }
+	[[nodiscard]] inline const_iterator begin() const { return m_entries.begin(); }
+	[[nodiscard]] inline const_iterator end() const { return m_entries.end(); }
+	
+	[[nodiscard]] inline iterator find(std::string_view key) { return begin() + locate(key); }
+	[[nodiscard]] inline const_iterator find(std::string_view key) const { return begin() + locate(key); }
+	[[nodiscard]] inline iterator find(key_type const & key) { return begin() + locate(key); }
+	[[nodiscard]] inline const_iterator find(key_type const & key) const { return begin() + locate(key); }
+	[[nodiscard]] inline bool contains(std::string_view key) const { return locate(key) != size(); }
+	[[nodiscard]] inline bool contains(key_type const & key) const { return locate(key) != size(); }
+	[[nodiscard]] inline size_t count(std::string_view key) const { return contains(key); }
+	
+	[[nodiscard]] inline V & at(std::string_view key) {
+		size_t i = locate(key);
+		if (i == size()) throw std::out_of_range {"flat_map::at"};
+		return m_entries[i].second;
+	}
+	[[nodiscard]] inline V const & at(std::string_view key) const { return const_cast<flat_map *>(this)->at(key); }
+	
+	inline V & operator [] (std::string_view key) { return try_emplace(key).first->second; }
+	inline V & operator [] (key_type const & key) { return try_emplace(key).first->second; }
+	
+	// The key is copied into the map if not already present.
+	template <typename ... ARGS> std::pair<iterator, bool> try_emplace(std::string_view key, ARGS && ... args) {
+		uint32_t hash = key_type::hash_of(key);
+		size_t i = locate(key, hash);
+		if (i != size()) return { begin() + i, false };
+		return { emplace_new(own_key(key, hash), std::forward<ARGS>(args)...), true };
+	}
+	
+	// Interned keys are stored as the same handle, any other key is copied as above.
+	template <typename ... ARGS> std::pair<iterator, bool> try_emplace(key_type const & key, ARGS && ... args) {
+		size_t i = locate(key);
+		if (i != size()) return { begin() + i, false };
+		return { emplace_new(key.interned() ? key : own_key(key.view(), key.hash()), std::forward<ARGS>(args)...), true };
+	}
+	
+	// As try_emplace, but the key is referenced rather than copied and must outlive the map.
+	template <typename ... ARGS> std::pair<iterator, bool> try_emplace_external(std::string_view key, ARGS && ... args) {
+		uint32_t hash = key_type::hash_of(key);
+		size_t i = locate(key, hash);
+		if (i != size()) return { begin() + i, false };
+		return { emplace_new(key_type::make(key.data(), key.size(), hash, key_type::EXTERNAL), std::forward<ARGS>(args)...), true };
+	}
+	
+	template <typename M> std::pair<iterator, bool> insert_or_assign(std::string_view key, M && value) {
+		auto ret = try_emplace(key, std::forward<M>(value));
+		if (!ret.second) ret.first->second = std::forward<M>(value);
+		return ret;
+	}
+	
+	// Erasing preserves the order of the remaining entries, shifting them down. The index is updated in place, only the
+	// slots of the shifted entries are revisited.
+	inline iterator erase(const_iterator pos) {
+		size_t i = pos - begin();
+		if (m_index) unindex_entry(i);
+		release_key(m_entries[i].first);
+		m_entries.erase(pos);
+		if (m_index && m_entries.size() <= LINEAR_MAX) release_index();
+		else if (m_index) for (size_t k = i; k < m_entries.size(); k++) m_index[slot_of(k, k + 1)] = static_cast<uint32_t>(k + 1);
+		return begin() + i;
+	}
+	
+	inline size_t erase(std::string_view key) {
+		size_t i = locate(key);
+		if (i == size()) return 0;
+		erase(begin() + i);
+		return 1;
+	}
+	
+	inline void clear() {
+		for (value_type & e : m_entries) release_key(e.first);
+		m_entries.clear();
+		release_index();
+	}
+	
+	// order independent, as befits a map
+	friend inline bool operator == (flat_map const & a, flat_map const & b) {
+		if (a.size() != b.size()) return false;
+		for (auto const & [key, value] : a) {
+			size_t i = b.locate(key);
+			if (i == b.size() || !(b.m_entries[i].second == value)) return false;
+		}
+		return true;
+	}
+
+private:
+
+	std::pmr::vector<value_type> m_entries;
+	uint32_t * m_index = nullptr; // entry position + 1 per slot, 0 for empty slots
+	uint32_t m_mask = 0;          // slot count - 1
+	
+	inline std::pmr::memory_resource * resource() const { return m_entries.get_allocator().resource(); }
+	
+	inline size_t locate(std::string_view key) const {
+		return locate(key, m_index ? key_type::hash_of(key) : 0);
+	}
+	
+	// with a precomputed hash the linear scan compares hashes first, and interned keys usually match by pointer
+	inline size_t locate(key_type const & key) const {
+		if (!m_index) {
+			for (size_t i = 0; i < m_entries.size(); i++) if (m_entries[i].first == key) return i;
+			return size();
+		}
+		return locate(key.view(), key.hash());
+	}
+	
+	// returns size() if not found, the hash is only consulted once indexed
+	inline size_t locate(std::string_view key, uint32_t hash) const {
+		if (!m_index) {
+			for (size_t i = 0; i < m_entries.size(); i++) {
+				key_type const & k = m_entries[i].first;
+				if (k.size() == key.size() && !std::memcmp(k.data(), key.data(), key.size())) return i;
+			}
+			return size();
+		}
+		for (uint32_t slot = hash & m_mask;; slot = (slot + 1) & m_mask) {
+			uint32_t e = m_index[slot];
+			if (!e) return size();
+			key_type const & k = m_entries[e - 1].first;
+			if (k.hash() == hash && k.view() == key) return e - 1;
+		}
+	}
+	
+	inline key_type own_key(std::string_view key, uint32_t hash) {
+		if (key.empty()) return key_type::make("", 0, hash, key_type::EXTERNAL);
+		char * data = static_cast<char *>(resource()->allocate(key.size(), 1));
+		std::memcpy(data, key.data(), key.size());
+		return key_type::make(data, key.size(), hash, 0);
+	}
+	
+	inline void release_key(key_type const & key) {
+		if (!key.external()) resource()->deallocate(const_cast<char *>(key.m_data), key.size(), 1);
+	}
+	
+	template <typename ... ARGS> iterator emplace_new(key_type key, ARGS && ... args) {
+		try {
+			m_entries.emplace_back(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<ARGS>(args)...));
+		} catch (...) {
+			release_key(key);
+			throw;
+		}
+		if (m_index && m_entries.size() * 2 <= m_mask + 1ull) index_entry(m_entries.size() - 1);
+		else if (m_index || m_entries.size() > LINEAR_MAX) rebuild_index();
+		return m_entries.end() - 1;
+	}
+	
+	inline void index_entry(size_t i) {
+		uint32_t slot = m_entries[i].first.hash() & m_mask;
+		while (m_index[slot]) slot = (slot + 1) & m_mask;
+		m_index[slot] = static_cast<uint32_t>(i + 1);
+	}
+	
+	// the slot holding the entry at position i, recorded as having position was
+	inline uint32_t slot_of(size_t i, size_t was) const {
+		uint32_t slot = m_entries[i].first.hash() & m_mask;
+		while (m_index[slot] != was + 1) slot = (slot + 1) & m_mask;
+		return slot;
+	}
+	
+	// Empties the entry's slot, then moves later entries of the probe sequence back into the gap wherever their home slot
+	// allows, so that every remaining entry is still found before the first empty slot.
+	inline void unindex_entry(size_t i) {
+		uint32_t slot = slot_of(i, i);
+		for (uint32_t next = (slot + 1) & m_mask; m_index[next]; next = (next + 1) & m_mask) {
+			uint32_t home = m_entries[m_index[next] - 1].first.hash() & m_mask;
+			if (((next - home) & m_mask) >= ((next - slot) & m_mask)) {
+				m_index[slot] = m_index[next];
+				slot = next;
+			}
+		}
+		m_index[slot] = 0;
+	}
+	
+	inline void release_index() {
+		if (m_index) resource()->deallocate(m_index, (m_mask + 1ull) * sizeof(uint32_t), alignof(uint32_t));
+		m_index = nullptr;
+		m_mask = 0;
+	}
+	
+	// at most half full, so probe sequences stay short
+	inline void rebuild_index() {
+		release_index();
+		if (m_entries.size() <= LINEAR_MAX) return;
+		size_t slots = 64;
+		while (slots < m_entries.size() * 2) slots *= 2;
+		m_index = static_cast<uint32_t *>(resource()->allocate(slots * sizeof(uint32_t), alignof(uint32_t)));
+		std::memset(m_index, 0, slots * sizeof(uint32_t));
+		m_mask = slots - 1;
+		for (size_t i = 0; i < m_entries.size(); i++) index_entry(i);
+	}
+};
@@ -1,13 +1,96 @@
 #include "meadow/aeon.hh"
+#include "meadow/buffer.hh"
 
-#include <iomanip>
-#include <locale>
-#include <sstream>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 using namespace meadow;
 
 static aeon const null_aeon;
 
+static_assert(sizeof(aeon) == 16);
+
+// The structural index of a lazily parsed input, shared by every container of it still lazy. A level is read from its own
+// tokens with those of each container nested in it reduced to its brackets, so reaching any depth only costs the levels on
+// the way there.
+struct aeon::lazy_index {
+	static constexpr uint32_t unmatched = std::numeric_limits<uint32_t>::max();
+	
+	std::atomic<size_t> refs { 1 };
+	char const * end = nullptr;
+	std::vector<char const *> tokens;
+	std::vector<uint32_t> close;        // for each token opening a container, the position of the one closing it
+	std::vector<char const *> controls; // control characters within strings, each making its string invalid
+	
+	inline void acquire() { refs.fetch_add(1, std::memory_order_relaxed); }
+	inline void release() { if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this; }
+	
+	// the JSON of the container opened by the given token
+	inline std::string_view span(uint32_t open) const { return { tokens[open], static_cast<size_t>(tokens[close[open]] + 1 - tokens[open]) }; }
+};
+
+// ================================================================
+// CONSTRUCTORS
+// ================================================================
+
+aeon::aeon(aeon const & other) : m_type(other.m_type), m_int(other.m_int) {
+	if (other.m_lazy) {
+		m_external = true;
+		m_lazy = true;
+		m_len = other.m_len;
+		m_index->acquire();
+		return;
+	}
+	switch (m_type) {
+		case type_t::string: m_str = new str_t(other.view()); break;
+		case type_t::array:
+			m_ary = new cached<ary_t>(other.m_ary->value);
+			break;
+		case type_t::map:
+			m_map = new cached<map_t>(other.m_map->value);
+			break;
+		default: break;
+	}
+}
+
+void aeon::release() {
+	if (m_lazy) {
+		m_index->release();
+		return;
+	}
+	switch (m_type) {
+		case type_t::string: delete m_str; break;
+		case type_t::array: delete m_ary; break;
+		case type_t::map: delete m_map; break;
+		default: break;
+	}
+}
+
 // ================================================================
 // GENERAL
 // ================================================================
@@ -18,12 +101,12 @@ size_t aeon::size() const {
 		constexpr size_t operator () (bool  const &  ) { return 1; }
 		constexpr size_t operator () (int_t const &  ) { return 1; }
 		constexpr size_t operator () (flt_t const &  ) { return 1; }
-		inline    size_t operator () (str_t const & v) { return v.size(); }
+		inline    size_t operator () (std::string_view v) { return v.size(); }
 		inline    size_t operator () (ary_t const & v) { return v.size(); }
 		inline    size_t operator () (map_t const & v) { return v.size(); }
 	};
 	
-	return std::visit(conversion_visitor {}, *value);
+	return visit(conversion_visitor {});
 }
 
 // ================================================================
@@ -35,7 +118,7 @@ size_t aeon::size() const {
 // ----------------
 bool & aeon::boolean() {
 	if (is_bool()) return get<bool>();
-	else return value->emplace<bool>();
+	else return emplace<bool>();
 }
 
 bool const & aeon::boolean() const {
@@ -49,7 +132,7 @@ bool const & aeon::boolean() const {
 // ----------------
 aeon::int_t & aeon::integer() {
 	if (is_integer()) return get<int_t>();
-	else return value->emplace<int_t>();
+	else return emplace<int_t>();
 }
 
 aeon::int_t const & aeon::integer() const {
@@ -63,7 +146,7 @@ aeon::int_t const & aeon::integer() const {
 // ----------------
 aeon::flt_t & aeon::floating() {
 	if (is_floating()) return get<flt_t>();
-	else return value->emplace<flt_t>();
+	else return emplace<flt_t>();
 }
 
 aeon::flt_t const & aeon::floating() const {
@@ -73,17 +156,21 @@ aeon::flt_t const & aeon::floating() const {
 }
 
 // ----------------
-// FLOATING
+// STRING
 // ----------------
 aeon::str_t & aeon::string() {
-	if (is_string()) return get<str_t>();
-	else return value->emplace<str_t>();
+	if (!is_string()) return emplace<str_t>();
+	if (m_external) {
+		str_t * str = new str_t(view());
+		m_external = false;
+		m_str = str;
+	}
+	return get<str_t>();
 }
 
-aeon::str_t const & aeon::string() const {
-	static str_t const default_value = "";
-	if (is_string()) return get<str_t>();
-	else return default_value;
+std::string_view aeon::string() const {
+	if (is_string()) return view();
+	else return {};
 }
 
 // ----------------
@@ -91,7 +178,7 @@ aeon::str_t const & aeon::string() const {
 // ----------------
 aeon::ary_t & aeon::array() {
 	if (is_array()) return get<ary_t>();
-	else return value->emplace<ary_t>();
+	else return emplace<ary_t>();
 }
 
 aeon::ary_t const & aeon::array() const {
@@ -105,7 +192,7 @@ aeon::ary_t const & aeon::array() const {
 // ----------------
 aeon::map_t & aeon::map() {
 	if (is_map()) return get<map_t>();
-	else return value->emplace<map_t>();
+	else return emplace<map_t>();
 }
 
 aeon::map_t const & aeon::map() const {
@@ -118,6 +205,36 @@ aeon::map_t const & aeon::map() const {
 // TYPE CONVERSIONS
 // ================================================================
 
+// Numbers are read and written with from_chars/to_chars, which neither allocate nor depend on the locale. Floating values are
+// written in the shortest form that reads back to the same value, always distinguishable from an integer.
+
+static constexpr size_t number_buffer_size = 32;
+
+static size_t format_integer(char * buf, aeon::int_t v) {
+	return std::to_chars(buf, buf + number_buffer_size, v).ptr - buf;
+}
+
+static size_t format_floating(char * buf, aeon::flt_t v) {
+	if (!std::isfinite(v)) {
+		std::memcpy(buf, "null", 4);
+		return 4;
+	}
+	char * end = std::to_chars(buf, buf + number_buffer_size, v).ptr;
+	if (std::find_if(buf, end, [](char c){ return c == '.' || c == 'e'; }) == end) {
+		*end++ = '.';
+		*end++ = '0';
+	}
+	return end - buf;
+}
+
+// leading whitespace and plus signs are tolerated, as they were with strtoll/strtod
+template <typename T> static T parse_number(std::string_view v) {
+	while (!v.empty() && (std::isspace(static_cast<unsigned char>(v.front())) || v.front() == '+')) v.remove_prefix(1);
+	T ret = 0;
+	std::from_chars(v.data(), v.data() + v.size(), ret);
+	return ret;
+}
+
 // ----------------
 // BOOLEAN
 // ----------------
@@ -127,12 +244,12 @@ bool aeon::as_boolean() const {
 		constexpr bool operator () (bool  const & v) { return v; }
 		constexpr bool operator () (int_t const & v) { return v; }
 		constexpr bool operator () (flt_t const & v) { return v; }
-		inline    bool operator () (str_t const & v) { return !v.empty() && v != "false"; }
+		inline    bool operator () (std::string_view v) { return !v.empty() && v != "false"; }
 		inline    bool operator () (ary_t const & v) { return v.size(); }
 		inline    bool operator () (map_t const & v) { return v.size(); }
 	};
 	
-	return std::visit(conversion_visitor {}, *value);
+	return visit(conversion_visitor {});
 }
 
 // ----------------
@@ -144,12 +261,12 @@ aeon::int_t aeon::as_integer() const {
 		constexpr int_t operator () (bool  const & v) { return v; }
 		constexpr int_t operator () (int_t const & v) { return v; }
 		constexpr int_t operator () (flt_t const & v) { return v; }
-		inline    int_t operator () (str_t const & v) { return std::strtoll(v.c_str(), nullptr, 10); }
+		inline    int_t operator () (std::string_view v) { return parse_number<int_t>(v); }
 		inline    int_t operator () (ary_t const & v) { return v.size(); }
 		inline    int_t operator () (map_t const & v) { return v.size(); }
 	};
 	
-	return std::visit(conversion_visitor {}, *value);
+	return visit(conversion_visitor {});
 }
 
 // ----------------
@@ -161,12 +278,12 @@ aeon::flt_t aeon::as_floating() const {
 		constexpr flt_t operator () (bool  const & v) { return v; }
 		constexpr flt_t operator () (int_t const & v) { return v; }
 		constexpr flt_t operator () (flt_t const & v) { return v; }
-		inline    flt_t operator () (str_t const & v) { return std::strtod(v.c_str(), nullptr); }
+		inline    flt_t operator () (std::string_view v) { return parse_number<flt_t>(v); }
 		inline    flt_t operator () (ary_t const & v) { return v.size(); }
 		inline    flt_t operator () (map_t const & v) { return v.size(); }
 	};
 	
-	return std::visit(conversion_visitor {}, *value);
+	return visit(conversion_visitor {});
 }
 
 // ----------------
@@ -176,14 +293,14 @@ aeon::str_t aeon::as_string() const {
 	struct conversion_visitor {
 		inline str_t operator () (nul_t const &  ) { return "null"; }
 		inline str_t operator () (bool  const & v) { return v ? "true" : "false"; }
-		inline str_t operator () (int_t const & v) { return std::to_string(v); }
-		inline str_t operator () (flt_t const & v) { return std::to_string(v); }
-		inline str_t operator () (str_t const & v) { return v; }
+		inline str_t operator () (int_t const & v) { char buf [number_buffer_size]; return str_t { buf, format_integer(buf, v) }; }
+		inline str_t operator () (flt_t const & v) { char buf [number_buffer_size]; return str_t { buf, format_floating(buf, v) }; }
+		inline str_t operator () (std::string_view v) { return str_t {v}; }
 		inline str_t operator () (ary_t const &  ) { return "[array]"; }
 		inline str_t operator () (map_t const &  ) { return "[map]"; }
 	};
 	
-	return std::visit(conversion_visitor {}, *value);
+	return visit(conversion_visitor {});
 }
 
 // ================================================================
@@ -194,63 +311,464 @@ aeon::str_t aeon::as_string() const {
 // SERIALIZE JSON
 // ----------------
 
-std::string aeon::jsonify_string(str_t const & str) {
-	std::ostringstream ss;
+// orders keys by UTF-16 code units as RFC 8785 requires, which only differs from byte order when comparing a code point
+// beyond the BMP (a surrogate pair in UTF-16, lead byte F0 to F4) against one from U+E000 to U+FFFF (lead byte EE or EF)
+static bool json_utf16_less(std::string_view a, std::string_view b) {
+	size_t n = std::min(a.size(), b.size());
+	size_t i = std::mismatch(a.begin(), a.begin() + n, b.begin()).first - a.begin();
+	if (i == n) return a.size() < b.size();
+	unsigned char ca = a[i], cb = b[i];
+	if (ca >= 0xF0 && (cb == 0xEE || cb == 0xEF)) return true;
+	if (cb >= 0xF0 && (ca == 0xEE || ca == 0xEF)) return false;
+	return ca < cb;
+}
+
+struct aeon::writer {
+	
+	static constexpr size_t CHUNK_SIZE = 1 << 16;
+	
+	sink_fn sink;
+	void * ctx;
+	size_t len = 0;
+	char chunk [CHUNK_SIZE];
+	
+	inline writer(sink_fn sink, void * ctx) : sink(sink), ctx(ctx) {}
+	
+	inline void flush() {
+		if (len) sink(ctx, chunk, len);
+		len = 0;
+	}
+	
+	inline void put(char c) {
+		if (len == CHUNK_SIZE) flush();
+		chunk[len++] = c;
+	}
+	
+	inline void put(char const * str, size_t n) {
+		if (n > CHUNK_SIZE - len) {
+			flush();
+			if (n >= CHUNK_SIZE) {
+				sink(ctx, str, n);
+				return;
+			}
+		}
+		std::memcpy(chunk + len, str, n);
+		len += n;
+	}
+	
+	inline void put(std::string_view str) { put(str.data(), str.size()); }
+	
+	static constexpr char hex [] = "0123456789abcdef";
+	
+	inline void put_u16(uint32_t v) {
+		char esc [] = { '\\', 'u', hex[v >> 12], hex[(v >> 8) & 0xF], hex[(v >> 4) & 0xF], hex[v & 0xF] };
+		put(esc, sizeof(esc));
+	}
+	
+	// escapes the UTF-8 sequence starting at cur and returns its last byte, an invalid byte is replaced on its own
+	char const * put_escaped_utf8(char const * cur, char const * end) {
+		unsigned char c = *cur;
+		size_t n = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+		uint32_t cp = c & (0x3F >> n);
+		bool valid = n && c < 0xF8 && static_cast<size_t>(end - cur) > n;
+		for (size_t i = 1; valid && i <= n; i++) {
+			unsigned char cc = cur[i];
+			valid = (cc & 0xC0) == 0x80;
+			cp = (cp << 6) | (cc & 0x3F);
+		}
+		constexpr uint32_t min [] = { 0, 0x80, 0x800, 0x10000 };
+		if (!valid || cp < min[n] || cp > 0x10FFFF || (cp >= 0xD800 && cp < 0xE000)) {
+			put_u16(0xFFFD);
+			return cur;
+		}
+		if (cp >= 0x10000) {
+			put_u16(0xD800 + ((cp - 0x10000) >> 10));
+			put_u16(0xDC00 + (cp & 0x3FF));
+		} else put_u16(cp);
+		return cur + n;
+	}
+	
+	template <bool ASCII = false> void put_string(std::string_view str) {
+		put('"');
+		char const * run = str.data();
+		char const * end = run + str.size();
+		for (char const * cur = run; cur < end; cur++) {
+			unsigned char c = *cur;
+			if (c >= 32 && c != '"' && c != '\\' && (!ASCII || c < 0x80)) continue;
+			put(run, cur - run);
+			if constexpr (ASCII) if (c >= 0x80) {
+				cur = put_escaped_utf8(cur, end);
+				run = cur + 1;
+				continue;
+			}
+			run = cur + 1;
+			switch(c) {
+				case '"': put("\\\"", 2); break;
+				case '\\': put("\\\\", 2); break;
+				case '\b': put("\\b", 2); break;
+				case '\f': put("\\f", 2); break;
+				case '\n': put("\\n", 2); break;
+				case '\r': put("\\r", 2); break;
+				case '\t': put("\\t", 2); break;
+				default: put_u16(c);
+			}
+		}
+		put(run, end - run);
+		put('"');
+	}
+	
+	void put_value(aeon const & value) {
+		if (value.m_lazy) {
+			std::string_view json = value.m_index->span(value.m_len);
+			put(json.data(), json.size());
+			return;
+		}
+		
+		struct conversion_visitor {
+			writer & w;
+			inline void operator () (nul_t const &  ) { w.put("null"); }
+			inline void operator () (bool  const & v) { w.put(v ? "true" : "false"); }
+			inline void operator () (int_t const & v) {
+				char buf [number_buffer_size];
+				w.put(buf, format_integer(buf, v));
+			}
+			inline void operator () (flt_t const & v) {
+				char buf [number_buffer_size];
+				w.put(buf, format_floating(buf, v));
+			}
+			inline void operator () (std::string_view v) { w.put_string(v); }
+			inline void operator () (ary_t const & v) {
+				w.put('[');
+				for (size_t i = 0; i < v.size(); i++) {
+					if (i) w.put(',');
+					w.put_value(v[i]);
+				}
+				w.put(']');
+			}
+			inline void operator () (map_t const & v) {
+				w.put('{');
+				bool first = true;
+				for (auto const & [key, value] : v) {
+					if (first) first = false;
+					else w.put(',');
+					w.put_string(key);
+					w.put(':');
+					w.put_value(value);
+				}
+				w.put('}');
+			}
+		};
+		
+		value.visit(conversion_visitor { *this });
+	}
+	
+	format fmt {};
+	size_t depth = 0;
+	std::vector<map_t::value_type const *> order {}; // entries of every map being written, each map sorts its own range
+	
+	inline void put_indent() {
+		static constexpr char spaces [] = "                                                                ";
+		if (!fmt.indent) return;
+		put('\n');
+		for (size_t n = depth * fmt.indent; n;) {
+			size_t k = std::min(n, sizeof(spaces) - 1);
+			put(spaces, k);
+			n -= k;
+		}
+	}
+	
+	inline void put_formatted_string(std::string_view str) {
+		if (fmt.ascii) put_string<true>(str);
+		else put_string(str);
+	}
 	
-	ss << '"';
-	for (auto c : str) {
-		switch(c) {
-			case '"': ss << "\\\""; break;
-			case '\\': ss << "\\\\"; break;
-			case '\b': ss << "\\b"; break;
-			case '\f': ss << "\\f"; break;
-			case '\n': ss << "\\n"; break;
-			case '\r': ss << "\\r"; break;
-			case '\t': ss << "\\t"; break;
-			default: {
-				if (c < 32) ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int32_t>(c);
-				else ss << c;
+	void put_formatted(aeon const & value) {
+		switch (value.type()) {
+			case type_t::string:
+				put_formatted_string(value.string());
+				return;
+			case type_t::floating:
+				if (fmt.canonical && value.floating() == 0) {
+					put("0.0", 3);
+					return;
+				}
+				break;
+			case type_t::array: {
+				ary_t const & ary = value.array();
+				put('[');
+				depth++;
+				for (size_t i = 0; i < ary.size(); i++) {
+					if (i) put(',');
+					put_indent();
+					put_formatted(ary[i]);
+				}
+				depth--;
+				if (!ary.empty()) put_indent();
+				put(']');
+				return;
 			}
+			case type_t::map: {
+				map_t const & map = value.map();
+				size_t base = order.size();
+				for (auto const & e : map) order.push_back(&e);
+				if (fmt.canonical) std::sort(order.begin() + base, order.end(), [](auto a, auto b){ return json_utf16_less(a->first.view(), b->first.view()); });
+				put('{');
+				depth++;
+				// nested maps push past this range, so entries are looked up by index rather than held by iterator
+				for (size_t i = base; i < base + map.size(); i++) {
+					if (i != base) put(',');
+					put_indent();
+					put_formatted_string(order[i]->first.view());
+					if (fmt.indent) put(": ", 2);
+					else put(':');
+					put_formatted(order[i]->second);
+				}
+				order.resize(base);
+				depth--;
+				if (!map.empty()) put_indent();
+				put('}');
+				return;
+			}
+			default: break;
 		}
+		put_value(value);
+	}
+	
+	// initial byte followed by an n byte big endian argument
+	inline void put_fixed(uint8_t initial, uint64_t arg, uint8_t n) {
+		char buf [9];
+		buf[0] = initial;
+		for (uint8_t i = 0; i < n; i++) buf[n - i] = static_cast<char>(arg >> (8 * i));
+		put(buf, n + 1);
+	}
+	
+	// CBOR item head, the argument is stored in the fewest bytes that hold it
+	inline void put_head(uint8_t major, uint64_t arg) {
+		major <<= 5;
+		if (arg < 24) put(static_cast<char>(major | arg));
+		else if (arg <= 0xFF) put_fixed(major | 24, arg, 1);
+		else if (arg <= 0xFFFF) put_fixed(major | 25, arg, 2);
+		else if (arg <= 0xFFFFFFFF) put_fixed(major | 26, arg, 4);
+		else put_fixed(major | 27, arg, 8);
+	}
+	
+	void put_binary(aeon const & value) {
+		struct conversion_visitor {
+			writer & w;
+			inline void operator () (nul_t const &  ) { w.put('\xF6'); }
+			inline void operator () (bool  const & v) { w.put(v ? '\xF5' : '\xF4'); }
+			inline void operator () (int_t const & v) {
+				if (v >= 0) w.put_head(0, v);
+				else w.put_head(1, -1 - v);
+			}
+			inline void operator () (flt_t const & v) {
+				float narrow = static_cast<float>(v);
+				if (narrow == v || std::isnan(v)) w.put_fixed(0xFA, std::bit_cast<uint32_t>(narrow), 4);
+				else w.put_fixed(0xFB, std::bit_cast<uint64_t>(v), 8);
+			}
+			inline void operator () (std::string_view v) {
+				w.put_head(3, v.size());
+				w.put(v);
+			}
+			inline void operator () (ary_t const & v) {
+				w.put_head(4, v.size());
+				for (aeon const & e : v) w.put_binary(e);
+			}
+			inline void operator () (map_t const & v) {
+				w.put_head(5, v.size());
+				for (auto const & [key, value] : v) {
+					w.put_head(3, key.size());
+					w.put(key);
+					w.put_binary(value);
+				}
+			}
+		};
+		
+		value.visit(conversion_visitor { *this });
 	}
-	ss << '"';
-	return ss.str();
+};
+
+static void string_sink(void * ctx, char const * data, size_t size) {
+	reinterpret_cast<std::string *>(ctx)->append(data, size);
 }
 
-std::string aeon::serialize_json() const {
-	struct conversion_visitor {
-		inline std::string operator () (nul_t const &  ) { return "null"; }
-		inline std::string operator () (bool  const & v) { return v ? "true" : "false"; }
-		inline std::string operator () (int_t const & v) { return std::to_string(v); }
-		inline std::string operator () (flt_t const & v) { std::ostringstream ss; ss << v; return ss.str(); }
-		inline std::string operator () (str_t const & v) { return jsonify_string(v); }
-		inline std::string operator () (ary_t const & v) {
-			std::ostringstream ss;
-			ss << "[";
-			for (size_t i = 0; i < v.size(); i++) {
-				if (i) ss << ",";
-				ss << v[i].serialize_json();
-			}
-			ss << "]";
-			return ss.str();
-		}
-		inline std::string operator () (map_t const & v) {
-			std::ostringstream ss;
-			ss << "{";
-			bool first = true;
-			for (auto const & [key, value] : v) {
-				if (first) first = false;
-				else ss << ",";
-				ss << jsonify_string(key);
-				ss << ':';
-				ss << value.serialize_json();
-			}
-			ss << "}";
-			return ss.str();
+static void buffer_sink(void * ctx, char const * data, size_t size) {
+	reinterpret_cast<buffer *>(ctx)->write(reinterpret_cast<buffer::byte_t const *>(data), size);
+}
+
+static void fd_sink(void * ctx, char const * data, size_t size) {
+	int fd = *reinterpret_cast<int *>(ctx);
+	while (size) {
+		ssize_t n = ::write(fd, data, size);
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			throw std::system_error { errno, std::generic_category(), "aeon::serialize" };
 		}
-	};
-	
-	return std::visit(conversion_visitor {}, *value);
+		data += n;
+		size -= n;
+	}
+}
+
+std::string aeon::jsonify_string(std::string_view str) {
+	std::string out;
+	out.reserve(str.size() + 2);
+	writer w { &string_sink, &out };
+	w.put_string(str);
+	w.flush();
+	return out;
+}
+
+std::string aeon::serialize_json() const {
+	std::string out;
+	serialize_json(&string_sink, &out);
+	return out;
+}
+
+void aeon::serialize_json(sink_fn sink, void * ctx) const {
+	writer w { sink, ctx };
+	w.put_value(*this);
+	w.flush();
+}
+
+void aeon::serialize_json(buffer & buf) const {
+	serialize_json(&buffer_sink, &buf);
+}
+
+void aeon::serialize_json(int fd) const {
+	serialize_json(&fd_sink, &fd);
+}
+
+std::string aeon::serialize_json(format const & fmt) const {
+	std::string out;
+	serialize_json(fmt, &string_sink, &out);
+	return out;
+}
+
+void aeon::serialize_json(format const & fmt, sink_fn sink, void * ctx) const {
+	writer w { sink, ctx };
+	w.fmt = fmt;
+	if (fmt.indent || fmt.canonical || fmt.ascii) w.put_formatted(*this);
+	else w.put_value(*this);
+	w.flush();
+}
+
+void aeon::serialize_json(format const & fmt, buffer & buf) const {
+	serialize_json(fmt, &buffer_sink, &buf);
+}
+
+void aeon::serialize_json(format const & fmt, int fd) const {
+	serialize_json(fmt, &fd_sink, &fd);
+}
+
+// ----------------
+// SERIALIZE BINARY
+// ----------------
+
+std::string aeon::serialize_binary() const {
+	std::string out;
+	serialize_binary(&string_sink, &out);
+	return out;
+}
+
+void aeon::serialize_binary(sink_fn sink, void * ctx) const {
+	writer w { sink, ctx };
+	w.put_binary(*this);
+	w.flush();
+}
+
+void aeon::serialize_binary(buffer & buf) const {
+	serialize_binary(&buffer_sink, &buf);
+}
+
+void aeon::serialize_binary(int fd) const {
+	serialize_binary(&fd_sink, &fd);
+}
+
+// ----------------
+// EMITTER
+// ----------------
+
+aeon::emitter::emitter(sink_fn sink, void * ctx) : m_writer { std::make_unique<writer>(sink, ctx) } {}
+aeon::emitter::emitter(std::string & out) : emitter { &string_sink, &out } {}
+aeon::emitter::emitter(buffer & buf) : emitter { &buffer_sink, &buf } {}
+
+aeon::emitter::~emitter() {
+	try { flush(); } catch (...) {}
+}
+
+void aeon::emitter::flush() {
+	m_writer->flush();
+}
+
+inline void aeon::emitter::separate() {
+	if (m_comma) m_writer->put(',');
+}
+
+void aeon::emitter::null() {
+	separate();
+	m_writer->put("null");
+	m_comma = true;
+}
+
+void aeon::emitter::boolean(bool v) {
+	separate();
+	m_writer->put(v ? "true" : "false");
+	m_comma = true;
+}
+
+void aeon::emitter::integer(int_t v) {
+	separate();
+	char buf [number_buffer_size];
+	m_writer->put(buf, format_integer(buf, v));
+	m_comma = true;
+}
+
+void aeon::emitter::floating(flt_t v) {
+	separate();
+	char buf [number_buffer_size];
+	m_writer->put(buf, format_floating(buf, v));
+	m_comma = true;
+}
+
+void aeon::emitter::string(std::string_view v) {
+	separate();
+	m_writer->put_string(v);
+	m_comma = true;
+}
+
+void aeon::emitter::key(std::string_view v) {
+	separate();
+	m_writer->put_string(v);
+	m_writer->put(':');
+	m_comma = false;
+}
+
+void aeon::emitter::start_array() {
+	separate();
+	m_writer->put('[');
+	m_comma = false;
+}
+
+void aeon::emitter::end_array() {
+	m_writer->put(']');
+	m_comma = true;
+}
+
+void aeon::emitter::start_map() {
+	separate();
+	m_writer->put('{');
+	m_comma = false;
+}
+
+void aeon::emitter::end_map() {
+	m_writer->put('}');
+	m_comma = true;
+}
+
+void aeon::emitter::value(aeon const & v) {
+	separate();
+	m_writer->put_value(v);
+	m_comma = true;
 }
 
 // ----------------
@@ -260,184 +778,2119 @@ std::string aeon::serialize_json() const {
 #define throw_eoi throw aeon::deserialize_exception {"unexpected end of input"}
 #define throw_ii throw aeon::deserialize_exception {"invalid input"}
 
-static inline void json_skip_irrelevant(char const * & cur, char const * end) {
-	for (;cur < end; cur++) switch (*cur) {
-		case ' ': case '\r': case '\n': case '\t':
-		case ',': case ':':
-			continue;
-		default: return;
-	}
-	throw_eoi;
-}
-
-static inline aeon::str_t json_parse_string(char const * & cur, char const * end) {
-	cur++;
-	char const * begin = cur;
-	bool escaped = false;
-	
-	std::ostringstream ss;
-	
-	for (;cur < end; cur++) {
-		char c = *cur;
-		if (c < 32) throw_ii;
-		switch (c) {
-			case 'b': if (escaped)  { ss << '\b'; escaped = false; } else ss << 'b'; continue;
-			case 'f': if (escaped)  { ss << '\f'; escaped = false; } else ss << 'f'; continue;
-			case 'n': if (escaped)  { ss << '\n'; escaped = false; } else ss << 'n'; continue;
-			case 'r': if (escaped)  { ss << '\r'; escaped = false; } else ss << 'r'; continue;
-			case 't': if (escaped)  { ss << '\t'; escaped = false; } else ss << 't'; continue;
-			case '\\': if (escaped) { ss << '\\'; escaped = false; } else escaped = true; continue;
-			case '"': if (escaped)  { ss << '"';  escaped = false; continue; } else break;
-			default: ss << c; continue;
-		}
-		break;
-	}
-	if (cur >= end || escaped) throw_eoi;
-	cur++;
-	
-	return ss.str();
-};
+// Deserialization is split into two passes. The first classifies the input 64 bytes at a time and produces an index of every
+// token start outside of strings (structural characters, scalar starts) plus every unescaped quote, the second walks that
+// index to build the tree without ever looking at whitespace or string contents byte by byte.
 
-static inline aeon deserialize_json_r(char const * & cur, char const * end) {
-	if (cur == end) throw_eoi;
-	
-	static constexpr auto validate_null = [](char const * & cur, char const * end) -> aeon {
-		if (cur+3 >= end) throw_eoi;
-		if (*(cur+1) != 'u' || *(cur+2) != 'l' || *(cur+3) != 'l') throw_ii;
-		cur += 4;
-		return {};
-	};
+namespace {
 	
-	static constexpr auto validate_true = [](char const * & cur, char const * end) -> aeon {
-		if (cur+3 >= end) throw_eoi;
-		if (*(cur+1) != 'r' || *(cur+2) != 'u' || *(cur+3) != 'e') throw_ii;
-		cur += 4;
-		return true;
+	struct json_masks {
+		uint64_t quote = 0;
+		uint64_t backslash = 0;
+		uint64_t whitespace = 0;
+		uint64_t structural = 0;
+		uint64_t control = 0;
 	};
 	
-	static constexpr auto validate_false = [](char const * & cur, char const * end) -> aeon {
-		if (cur+4 >= end) throw_eoi;
-		if (*(cur+1) != 'a' || *(cur+2) != 'l' || *(cur+3) != 's' || *(cur+4) != 'e') throw_ii;
-		cur += 5;
-		return false;
+	enum json_class : uint8_t {
+		jc_quote      = 1 << 0,
+		jc_backslash  = 1 << 1,
+		jc_whitespace = 1 << 2,
+		jc_structural = 1 << 3,
+		jc_control    = 1 << 4,
 	};
 	
-	static constexpr auto parse_numerical = [](char const * & cur, char const * end) -> aeon {
-		char const * begin = cur;
-		char const * exp = nullptr;
-		bool is_floating = false;
-		
-		for (;cur != end; cur++) {
-			switch (*cur) {
-				case '.': 
-					if (is_floating) throw_ii;
-					is_floating = true;
-					continue;
-				case 'e': case 'E':
-					if (exp) throw_ii;
-					exp = cur;
-					continue;
-				case '+': case '-': 
-					if (cur != begin && !(exp && cur == exp + 1)) throw_ii;
-					[[fallthrough]];
-				case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9':
-					continue;
-				default: break;
-			}
-			break;
-		}
-		if (cur == begin) throw_eoi;
+	constexpr auto json_class_table = [](){
+		std::array<uint8_t, 256> table {};
+		for (size_t i = 0; i < 32; i++) table[i] |= jc_control;
+		table['"'] |= jc_quote;
+		table['\\'] |= jc_backslash;
+		for (unsigned char c : {' ', '\t', '\n', '\r'}) table[c] |= jc_whitespace;
+		for (unsigned char c : {'{', '}', '[', ']', ',', ':'}) table[c] |= jc_structural;
+		return table;
+	}();
+}
 
-		std::string numstr {begin, cur};
-		if (is_floating || exp) return std::strtod(numstr.c_str(), nullptr);
-		else return std::strtoll(numstr.c_str(), nullptr, 10);
-	};
-	
-	static constexpr auto parse_array = [](char const * & cur, char const * end) -> aeon {
-		cur++;
-		aeon ret; ret.array();
-		for (;cur < end;) {
-			json_skip_irrelevant(cur, end);
-			if (*cur == ']') {
-				cur++;
-				return ret;
-			}
-			ret.array().push_back(deserialize_json_r(cur, end));
-		}
-		throw_eoi;
-	};
+static json_masks json_classify_scalar(char const * blk) {
+	json_masks m;
+	for (size_t i = 0; i < 64; i++) {
+		uint8_t c = json_class_table[static_cast<uint8_t>(blk[i])];
+		m.quote      |= static_cast<uint64_t>((c & jc_quote)      != 0) << i;
+		m.backslash  |= static_cast<uint64_t>((c & jc_backslash)  != 0) << i;
+		m.whitespace |= static_cast<uint64_t>((c & jc_whitespace) != 0) << i;
+		m.structural |= static_cast<uint64_t>((c & jc_structural) != 0) << i;
+		m.control    |= static_cast<uint64_t>((c & jc_control)    != 0) << i;
+	}
+	return m;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// SSE2 is sufficient for the classification below (brackets and braces are folded together with |0x20, control characters
+// are found with an unsigned max), so the 16-byte path needs nothing beyond the baseline instruction set
+
+__attribute__((target("sse2"))) static json_masks json_classify_sse2(char const * blk) {
+	json_masks m;
+	__m128i const v_quote = _mm_set1_epi8('"');
+	__m128i const v_bslash = _mm_set1_epi8('\\');
+	__m128i const v_space = _mm_set1_epi8(' ');
+	__m128i const v_tab = _mm_set1_epi8('\t');
+	__m128i const v_lf = _mm_set1_epi8('\n');
+	__m128i const v_cr = _mm_set1_epi8('\r');
+	__m128i const v_fold = _mm_set1_epi8(0x20);
+	__m128i const v_open = _mm_set1_epi8('{');
+	__m128i const v_close = _mm_set1_epi8('}');
+	__m128i const v_comma = _mm_set1_epi8(',');
+	__m128i const v_colon = _mm_set1_epi8(':');
+	__m128i const v_ctl = _mm_set1_epi8(0x1F);
+	for (size_t i = 0; i < 4; i++) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(blk + i * 16));
+		__m128i f = _mm_or_si128(v, v_fold);
+		__m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, v_space), _mm_cmpeq_epi8(v, v_tab)), _mm_or_si128(_mm_cmpeq_epi8(v, v_lf), _mm_cmpeq_epi8(v, v_cr)));
+		__m128i st = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(f, v_open), _mm_cmpeq_epi8(f, v_close)), _mm_or_si128(_mm_cmpeq_epi8(v, v_comma), _mm_cmpeq_epi8(v, v_colon)));
+		__m128i ct = _mm_cmpeq_epi8(_mm_max_epu8(v, v_ctl), v_ctl);
+		m.quote      |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, v_quote)))) << (i * 16);
+		m.backslash  |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, v_bslash)))) << (i * 16);
+		m.whitespace |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(ws))) << (i * 16);
+		m.structural |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(st))) << (i * 16);
+		m.control    |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(ct))) << (i * 16);
+	}
+	return m;
+}
+
+__attribute__((target("avx2"))) static json_masks json_classify_avx2(char const * blk) {
+	json_masks m;
+	__m256i const v_quote = _mm256_set1_epi8('"');
+	__m256i const v_bslash = _mm256_set1_epi8('\\');
+	__m256i const v_space = _mm256_set1_epi8(' ');
+	__m256i const v_tab = _mm256_set1_epi8('\t');
+	__m256i const v_lf = _mm256_set1_epi8('\n');
+	__m256i const v_cr = _mm256_set1_epi8('\r');
+	__m256i const v_fold = _mm256_set1_epi8(0x20);
+	__m256i const v_open = _mm256_set1_epi8('{');
+	__m256i const v_close = _mm256_set1_epi8('}');
+	__m256i const v_comma = _mm256_set1_epi8(',');
+	__m256i const v_colon = _mm256_set1_epi8(':');
+	__m256i const v_ctl = _mm256_set1_epi8(0x1F);
+	for (size_t i = 0; i < 2; i++) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(blk + i * 32));
+		__m256i f = _mm256_or_si256(v, v_fold);
+		__m256i ws = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, v_space), _mm256_cmpeq_epi8(v, v_tab)), _mm256_or_si256(_mm256_cmpeq_epi8(v, v_lf), _mm256_cmpeq_epi8(v, v_cr)));
+		__m256i st = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(f, v_open), _mm256_cmpeq_epi8(f, v_close)), _mm256_or_si256(_mm256_cmpeq_epi8(v, v_comma), _mm256_cmpeq_epi8(v, v_colon)));
+		__m256i ct = _mm256_cmpeq_epi8(_mm256_max_epu8(v, v_ctl), v_ctl);
+		m.quote      |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, v_quote)))) << (i * 32);
+		m.backslash  |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, v_bslash)))) << (i * 32);
+		m.whitespace |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(ws))) << (i * 32);
+		m.structural |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(st))) << (i * 32);
+		m.control    |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(ct))) << (i * 32);
+	}
+	return m;
+}
+
+#endif
+
+using json_classify_fn = json_masks (*)(char const *);
+
+static json_classify_fn const json_classify = [](){
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return &json_classify_avx2;
+	if (__builtin_cpu_supports("sse2")) return &json_classify_sse2;
+#endif
+	return &json_classify_scalar;
+}();
+
+// returns the first control character within a string, strings extending past it are invalid
+// indexing stops with a limit_exception once more than max_tokens are found, so a rejected input costs no more than that
+// every control character within a string is also recorded in controls, if given
+static char const * json_build_index(char const * begin, char const * end, std::vector<char const *> & tokens, size_t max_tokens = SIZE_MAX, std::vector<char const *> * controls = nullptr) {
+	char const * first_control = end;
+	tokens.reserve(std::min(static_cast<size_t>(end - begin) / 4 + 1, max_tokens));
 	
-	static constexpr auto parse_map = [](char const * & cur, char const * end) -> aeon {
-		cur++;
-		aeon ret; ret.map();
-		for (;cur < end;) {
-			json_skip_irrelevant(cur, end);
-			if (*cur == '}') {
-				cur++;
-				return ret;
-			}
-			aeon::str_t str = json_parse_string(cur, end);
-			json_skip_irrelevant(cur, end);
-			ret[str] = deserialize_json_r(cur, end);
-		}
-		throw_eoi;
-	};
+	uint64_t prev_escaped = 0;   // first character of the next block is escaped
+	uint64_t prev_in_string = 0; // all ones if the previous block ended inside a string
+	uint64_t prev_scalar = 0;    // last character of the previous block was part of a scalar
 	
-	json_skip_irrelevant(cur, end);
-	for (;cur < end; cur++) switch(*cur) {
-		case 'n': return validate_null(cur, end);
-		case 't': return validate_true(cur, end);
-		case 'f': return validate_false(cur, end);
+	char tail [64];
+	for (char const * blk = begin; blk < end; blk += 64) {
+		size_t len = end - blk;
+		char const * src = blk;
+		if (len < 64) {
+			std::memcpy(tail, blk, len);
+			std::memset(tail + len, ' ', 64 - len);
+			src = tail;
+		}
 		
-		case '-':
-		case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9':
-		return parse_numerical(cur, end);
+		json_masks m = json_classify(src);
+		
+		// backslash runs are rare enough that resolving them bit by bit beats the carry-propagation tricks
+		uint64_t escaped = prev_escaped;
+		uint64_t bs = m.backslash & ~prev_escaped;
+		prev_escaped = 0;
+		while (bs) {
+			int i = __builtin_ctzll(bs);
+			if (i == 63) { prev_escaped = 1; break; }
+			escaped |= 2ULL << i;
+			bs &= ~(3ULL << i);
+		}
 		
-		case '"': return json_parse_string(cur, end);
-		case '[': return parse_array(cur, end);
-		case '{': return parse_map(cur, end);
+		uint64_t quote = m.quote & ~escaped;
 		
-		default: throw_ii;
+		// prefix xor, leaves the opening quote and string contents set while the closing quote is clear
+		uint64_t in_string = quote;
+		in_string ^= in_string << 1;
+		in_string ^= in_string << 2;
+		in_string ^= in_string << 4;
+		in_string ^= in_string << 8;
+		in_string ^= in_string << 16;
+		in_string ^= in_string << 32;
+		in_string ^= prev_in_string;
+		prev_in_string = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+		
+		uint64_t control = m.control & in_string & ~quote;
+		if (control && first_control == end)
+			first_control = blk + __builtin_ctzll(control);
+		if (controls) for (uint64_t c = control; c; c &= c - 1) controls->push_back(blk + __builtin_ctzll(c));
+		
+		uint64_t scalar = ~(m.structural | m.whitespace | m.quote) & ~in_string;
+		uint64_t scalar_start = scalar & ~((scalar << 1) | prev_scalar);
+		prev_scalar = scalar >> 63;
+		
+		uint64_t found = (m.structural & ~in_string) | quote | scalar_start;
+		if (len < 64) found &= (1ULL << len) - 1;
+		
+		size_t base = tokens.size();
+		size_t count = base + __builtin_popcountll(found);
+		if (count > max_tokens) throw aeon::limit_exception {"too many values"};
+		if (count > tokens.capacity()) tokens.reserve(std::min(std::max(count, 2 * tokens.capacity()), max_tokens));
+		tokens.resize(count);
+		char const * * out = tokens.data() + base;
+		while (found) {
+			*out++ = blk + __builtin_ctzll(found);
+			found &= found - 1;
+		}
 	}
 	
-	throw_eoi;
+	return first_control;
 }
 
-aeon aeon::deserialize_json(char const * cur, char const * end) {
-	return deserialize_json_r(cur, end);
+static inline bool json_is_scalar_char(char c) {
+	return !(json_class_table[static_cast<uint8_t>(c)] & (jc_quote | jc_whitespace | jc_structural));
 }
 
-// ================================================================
-// OPERATORS
-// ================================================================
+// RFC 8259: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+static bool json_is_number(char const * cur, char const * end) {
+	auto digits = [&](){
+		char const * start = cur;
+		while (cur != end && *cur >= '0' && *cur <= '9') cur++;
+		return cur != start;
+	};
+	if (cur != end && *cur == '-') cur++;
+	if (cur != end && *cur == '0') cur++;
+	else if (!digits()) return false;
+	if (cur != end && *cur == '.') {
+		cur++;
+		if (!digits()) return false;
+	}
+	if (cur != end && (*cur == 'e' || *cur == 'E')) {
+		cur++;
+		if (cur != end && (*cur == '+' || *cur == '-')) cur++;
+		if (!digits()) return false;
+	}
+	return cur == end;
+}
 
-// ----------------
-// ARRAY
-// ----------------
-aeon & aeon::operator [] (size_t idx) {
-	auto & ary = array();
-	if (idx >= ary.size()) ary.resize(idx + 1);
-	return ary[idx];
+static inline char * json_append_utf8(char * out, uint32_t cp) {
+	if (cp < 0x80) {
+		*out++ = static_cast<char>(cp);
+	} else if (cp < 0x800) {
+		*out++ = static_cast<char>(0xC0 | (cp >> 6));
+		*out++ = static_cast<char>(0x80 | (cp & 0x3F));
+	} else if (cp < 0x10000) {
+		*out++ = static_cast<char>(0xE0 | (cp >> 12));
+		*out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+		*out++ = static_cast<char>(0x80 | (cp & 0x3F));
+	} else {
+		*out++ = static_cast<char>(0xF0 | (cp >> 18));
+		*out++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+		*out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+		*out++ = static_cast<char>(0x80 | (cp & 0x3F));
+	}
+	return out;
 }
 
-aeon const & aeon::operator [] (size_t idx) const {
-	auto const & ary = array();
-	if (idx >= ary.size()) return null_aeon;
-	return ary[idx];
+static inline uint32_t json_parse_hex4(char const * cur, char const * end) {
+	if (end - cur < 4) throw_ii;
+	uint32_t v = 0;
+	for (size_t i = 0; i < 4; i++) {
+		char c = cur[i];
+		v <<= 4;
+		if (c >= '0' && c <= '9') v |= c - '0';
+		else if (c >= 'a' && c <= 'f') v |= c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F') v |= c - 'A' + 10;
+		else throw_ii;
+	}
+	return v;
+}
+
+// begin and end delimit the string contents, excluding quotes, as found by the index
+// escapes never expand, so out must have room for end - begin bytes, returns the end of the written contents
+static char * json_unescape_string(char const * begin, char const * end, char * out) {
+	for (char const * cur = begin;;) {
+		char const * esc = reinterpret_cast<char const *>(std::memchr(cur, '\\', end - cur));
+		if (!esc) {
+			std::memcpy(out, cur, end - cur);
+			return out + (end - cur);
+		}
+		std::memcpy(out, cur, esc - cur);
+		out += esc - cur;
+		if (esc + 1 >= end) throw_ii;
+		cur = esc + 2;
+		switch (esc[1]) {
+			case '"': *out++ = '"'; break;
+			case '\\': *out++ = '\\'; break;
+			case '/': *out++ = '/'; break;
+			case 'b': *out++ = '\b'; break;
+			case 'f': *out++ = '\f'; break;
+			case 'n': *out++ = '\n'; break;
+			case 'r': *out++ = '\r'; break;
+			case 't': *out++ = '\t'; break;
+			case 'u': {
+				uint32_t cp = json_parse_hex4(cur, end);
+				cur += 4;
+				if (cp >= 0xD800 && cp < 0xDC00) {
+					if (end - cur < 6 || cur[0] != '\\' || cur[1] != 'u') throw_ii;
+					uint32_t lo = json_parse_hex4(cur + 2, end);
+					if (lo < 0xDC00 || lo >= 0xE000) throw_ii;
+					cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+					cur += 6;
+				}
+				out = json_append_utf8(out, cp);
+				break;
+			}
+			default: throw_ii;
+		}
+	}
 }
 
 // ----------------
-// MAP
+// READER
 // ----------------
-aeon & aeon::operator [] (str_t const & key) {
-	return map()[key];
+
+aeon::reader::reader(char const * begin, char const * end) : m_end(end) {
+	m_first_control = json_build_index(begin, end, m_tokens);
 }
 
-aeon const & aeon::operator [] (str_t const & key) const {
-	auto const & val = map();
-	auto i = val.find(key);
-	if (i == val.end()) return null_aeon;
-	else return i->second;
+aeon::reader::reader(char const * begin, char const * end, limits const & lim) : m_end(end), m_strict(true), m_limits(lim) {
+	if (static_cast<size_t>(end - begin) > lim.max_input) throw limit_exception {"input too large"};
+	// a value takes at most six tokens: a key's two quotes and colon, its own one or two, and a comma
+	size_t max_tokens = lim.max_nodes > SIZE_MAX / 6 ? SIZE_MAX : lim.max_nodes * 6;
+	m_first_control = json_build_index(begin, end, m_tokens, max_tokens);
+}
+
+aeon::reader::reader(std::vector<char const *> && tokens, char const * end, char const * first_control) :
+	m_end(end),
+	m_first_control(first_control),
+	m_tokens(std::move(tokens))
+{}
+
+char const * aeon::reader::next_token() {
+	if (m_pos >= m_tokens.size()) throw_eoi;
+	return m_tokens[m_pos++];
+}
+
+// commas and colons carry no information and are skipped wherever they appear
+char const * aeon::reader::next_relevant() {
+	for (;;) {
+		char const * tok = next_token();
+		if (*tok != ',' && *tok != ':') return tok;
+	}
+}
+
+// consumes the separator the grammar requires before the next token, if any, and returns that token
+char const * aeon::reader::next_strict() {
+	char const * prev = m_pos ? m_tokens[m_pos - 1] : nullptr;
+	char const * tok = next_token();
+	if (m_stack.empty()) return tok;
+	switch (m_stack.back()) {
+		case frame_t::array:
+		case frame_t::map_key: {
+			char open = m_stack.back() == frame_t::array ? '[' : '{';
+			if (*prev == open) return tok;
+			if (*tok == ',') {
+				tok = next_token();
+				if (*tok == ']' || *tok == '}') throw_ii;
+				return tok;
+			}
+			if (*tok != open + 2) throw_ii; // the matching close, ']' and '}' follow their openers by two
+			return tok;
+		}
+		case frame_t::map_value:
+			if (*tok != ':') throw_ii;
+			return next_token();
+	}
+	return tok;
+}
+
+void aeon::reader::push(frame_t f) {
+	if (m_strict && m_stack.size() >= m_limits.max_depth) throw limit_exception {"nesting too deep"};
+	m_stack.push_back(f);
+}
+
+// scalars must be followed by whitespace, a structural character, or the end of input
+void aeon::reader::check_scalar_end(char const * cur) const {
+	if (cur < m_end && json_is_scalar_char(*cur)) throw_ii;
+}
+
+void aeon::reader::read_string(char const * tok) {
+	char const * begin = tok + 1;
+	char const * close = next_token();
+	if (close > m_first_control) throw_ii;
+	size_t len = close - begin;
+	if (m_strict && len > m_limits.max_string) throw limit_exception {"string too long"};
+	
+	m_borrowed = !std::memchr(begin, '\\', len);
+	if (m_borrowed) {
+		m_str = { begin, len };
+	} else {
+		m_scratch.resize(len);
+		m_str = { m_scratch.data(), static_cast<size_t>(json_unescape_string(begin, close, m_scratch.data()) - m_scratch.data()) };
+	}
+}
+
+void aeon::reader::read_literal(char const * cur, std::string_view lit) {
+	if (static_cast<size_t>(m_end - cur) < lit.size()) throw_eoi;
+	if (std::memcmp(cur, lit.data(), lit.size())) throw_ii;
+	check_scalar_end(cur + lit.size());
+}
+
+void aeon::reader::read_numerical(char const * cur) {
+	char const * begin = cur;
+	char const * end = m_end;
+	char const * exp = nullptr;
+	bool is_floating = false;
+	
+	for (;cur != end; cur++) {
+		switch (*cur) {
+			case '.': 
+				if (is_floating) throw_ii;
+				is_floating = true;
+				continue;
+			case 'e': case 'E':
+				if (exp) throw_ii;
+				exp = cur;
+				continue;
+			case '+': case '-': 
+				if (cur != begin && !(exp && cur == exp + 1)) throw_ii;
+				[[fallthrough]];
+			case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9':
+				continue;
+			default: break;
+		}
+		break;
+	}
+	check_scalar_end(cur);
+	
+	if (m_strict) {
+		if (static_cast<size_t>(cur - begin) > m_limits.max_number) throw limit_exception {"number too long"};
+		if (!json_is_number(begin, cur)) throw_ii;
+		if (!m_convert) {
+			m_event = is_floating || exp ? event_t::floating : event_t::integer;
+			return;
+		}
+	}
+	
+	// integers too large for int_t are read as floating values instead
+	if (!is_floating && !exp) {
+		auto [ptr, ec] = std::from_chars(begin, cur, m_int);
+		if (ptr != cur) throw_ii;
+		if (ec == std::errc {}) {
+			m_event = event_t::integer;
+			return;
+		}
+	}
+	
+	m_event = event_t::floating;
+	auto [ptr, ec] = std::from_chars(begin, cur, m_flt);
+	if (ptr != cur) throw_ii;
+	if (ec == std::errc::result_out_of_range) m_flt = std::strtod(str_t {begin, cur}.c_str(), nullptr); // infinity or denormal
+}
+
+bool aeon::reader::next() {
+	if (m_started && m_stack.empty()) {
+		if ((m_strict || m_whole) && m_pos != m_tokens.size()) throw_ii;
+		m_event = event_t::none;
+		return false;
+	}
+	m_started = true;
+	
+	char const * tok = m_strict ? next_strict() : next_relevant();
+	
+	if (!m_stack.empty()) switch (m_stack.back()) {
+		case frame_t::array:
+			if (*tok != ']') break;
+			m_stack.pop_back();
+			m_event = event_t::end_array;
+			return true;
+		case frame_t::map_key:
+			if (*tok == '}') {
+				m_stack.pop_back();
+				m_event = event_t::end_map;
+				return true;
+			}
+			if (*tok != '"') throw_ii;
+			read_string(tok);
+			m_stack.back() = frame_t::map_value;
+			m_event = event_t::key;
+			return true;
+		case frame_t::map_value:
+			m_stack.back() = frame_t::map_key;
+			break;
+	}
+	
+	if (m_strict && ++m_nodes > m_limits.max_nodes) throw limit_exception {"too many values"};
+	
+	switch(*tok) {
+		case 'n': read_literal(tok, "null"); m_event = event_t::null; return true;
+		case 't': read_literal(tok, "true"); m_bool = true; m_event = event_t::boolean; return true;
+		case 'f': read_literal(tok, "false"); m_bool = false; m_event = event_t::boolean; return true;
+		
+		case '-':
+		case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9':
+		read_numerical(tok);
+		return true;
+		
+		case '"': read_string(tok); m_event = event_t::string; return true;
+		case '[': push(frame_t::array); m_event = event_t::start_array; return true;
+		case '{': push(frame_t::map_key); m_event = event_t::start_map; return true;
+		
+		default: throw_ii;
+	}
+}
+
+void aeon::reader::skip() {
+	if (m_event != event_t::start_array && m_event != event_t::start_map) return;
+	// strings are a pair of quote tokens and scalars a single token, so only brackets matter
+	for (size_t depth = 1; depth;) switch (*next_token()) {
+		case '[': case '{': depth++; break;
+		case ']': case '}': depth--; break;
+		default: break;
+	}
+	m_event = m_stack.back() == frame_t::array ? event_t::end_array : event_t::end_map;
+	m_stack.pop_back();
+}
+
+// ----------------
+// TREE BUILDING
+// ----------------
+
+// Builds the tree from reader events, either as ordinary owned values or, given an arena, as external values whose
+// storage is bump allocated from it. Borrowing leaves strings that needed no unescaping as external views into the input.
+// Any source with the reader's event interface can drive it, so every input format shares one tree construction.
+struct aeon::builder {
+	
+	struct frame {
+		aeon map;      // the map being built, null for arrays
+		size_t base;   // first element of the array on the element stack
+		aeon * slot;   // value slot claimed by the last key
+	};
+	
+	std::pmr::memory_resource * arena = nullptr;
+	bool borrow = false;
+	key_pool * pool = key_pool::current();
+	bool lazy = false; // nested containers are left unparsed, only possible when reading JSON
+	lazy_index * index = nullptr; // the index they refer to
+	
+	std::vector<frame> frames {};
+	std::vector<aeon> stack {}; // elements of every array currently being parsed, so each is allocated once at its final size
+	
+	template <typename T> cached<T> * make_external(aeon & v, type_t type) {
+		v.m_type = type;
+		v.m_external = true;
+		return new (arena->allocate(sizeof(cached<T>), alignof(cached<T>))) cached<T> (arena);
+	}
+	
+	aeon make_string(std::string_view str, bool borrowed) {
+		aeon ret;
+		if (borrow && borrowed && str.size() <= std::numeric_limits<uint32_t>::max()) {
+			ret.m_type = type_t::string;
+			ret.m_external = true;
+			ret.m_view = str.data();
+			ret.m_len = str.size();
+		} else if (arena) {
+			if (str.size() > std::numeric_limits<uint32_t>::max()) throw aeon::deserialize_exception {"string too large for document"};
+			char * buf = reinterpret_cast<char *>(arena->allocate(str.size() ? str.size() : 1, 1));
+			std::memcpy(buf, str.data(), str.size());
+			ret.m_type = type_t::string;
+			ret.m_external = true;
+			ret.m_view = buf;
+			ret.m_len = str.size();
+		} else {
+			ret.emplace<str_t>().assign(str);
+		}
+		return ret;
+	}
+	
+	aeon make_array(size_t base) {
+		aeon ret;
+		ary_t & ary = arena ? (ret.m_ary = make_external<ary_t>(ret, type_t::array))->value : ret.emplace<ary_t>();
+		ary.assign(std::make_move_iterator(stack.begin() + base), std::make_move_iterator(stack.end()));
+		stack.resize(base);
+		return ret;
+	}
+	
+	aeon make_map() {
+		aeon ret;
+		if (arena) ret.m_map = make_external<map_t>(ret, type_t::map);
+		else ret.emplace<map_t>();
+		return ret;
+	}
+	
+	// the token opening the container, found among those of the index as they are in input order
+	aeon make_lazy(char const * open) {
+		aeon ret;
+		ret.m_type = *open == '[' ? type_t::array : type_t::map;
+		ret.m_external = true;
+		ret.m_lazy = true;
+		ret.m_len = std::lower_bound(index->tokens.begin(), index->tokens.end(), open) - index->tokens.begin();
+		ret.m_index = index;
+		index->acquire();
+		return ret;
+	}
+	
+	template <typename R> aeon consume(R & r) {
+		aeon root;
+		while (r.next()) {
+			aeon v;
+			switch (r.event()) {
+				case event_t::none: continue;
+				case event_t::null: break;
+				case event_t::boolean: v = aeon { r.boolean() }; break;
+				case event_t::integer: v = aeon { r.integer() }; break;
+				case event_t::floating: v = aeon { r.floating() }; break;
+				case event_t::string: v = make_string(r.string(), r.borrowed()); break;
+				case event_t::key: {
+					// later duplicates overwrite, borrowed keys are referenced like borrowed strings
+					map_t & map = frames.back().map.m_map->value;
+					auto i =
+						pool ? map.try_emplace(pool->intern(r.string())).first :
+						borrow && r.borrowed() ? map.try_emplace_external(r.string()).first :
+						map.try_emplace(r.string()).first;
+					frames.back().slot = &i->second;
+					continue;
+				}
+				case event_t::start_array:
+				case event_t::start_map:
+					if constexpr (std::is_same_v<std::remove_cvref_t<R>, reader>) if (lazy && !frames.empty()) {
+						char const * open = r.position();
+						r.skip();
+						v = make_lazy(open);
+						break;
+					}
+					if (r.event() == event_t::start_array) frames.push_back({ {}, stack.size(), nullptr });
+					else frames.push_back({ make_map(), 0, nullptr });
+					continue;
+				case event_t::end_array:
+					v = make_array(frames.back().base);
+					frames.pop_back();
+					break;
+				case event_t::end_map:
+					v = std::move(frames.back().map);
+					frames.pop_back();
+					break;
+			}
+			
+			if (frames.empty()) root = std::move(v);
+			else if (frames.back().map.is_map()) *frames.back().slot = std::move(v);
+			else stack.push_back(std::move(v));
+		}
+		return root;
+	}
+	
+	template <typename R> static aeon build(R && r, bool borrow) {
+		builder b { nullptr, borrow };
+		return b.consume(r);
+	}
+	
+	static aeon build_lazy(char const * begin, char const * end) {
+		lazy_index * index = new lazy_index;
+		struct hold_t { lazy_index * p; ~hold_t() { p->release(); } } hold { index };
+		index->end = end;
+		char const * first_control = json_build_index(begin, end, index->tokens, SIZE_MAX, &index->controls);
+		
+		// token positions are kept in 32 bits, an input with more is parsed in full
+		size_t n = index->tokens.size();
+		if (n >= lazy_index::unmatched) {
+			reader r { std::move(index->tokens), end, first_control };
+			builder b { nullptr, true };
+			return b.consume(r);
+		}
+		
+		index->close.assign(n, lazy_index::unmatched);
+		std::vector<uint32_t> open;
+		for (uint32_t i = 0; i < n; i++) switch (*index->tokens[i]) {
+			case '[': case '{': open.push_back(i); break;
+			case ']': case '}':
+				if (open.empty()) break;
+				index->close[open.back()] = i;
+				open.pop_back();
+				break;
+			default: break;
+		}
+		return build_level(*index, 0, n);
+	}
+	
+	// Parses the tokens from first to last (exclusive) of the index, leaving each container nested within them lazy. Its
+	// tokens are skipped past in one go, though not if unbalanced, which is then found as the reader runs past the end.
+	static aeon build_level(lazy_index & index, size_t first, size_t last) {
+		std::vector<char const *> tokens;
+		for (size_t i = first; i < last; i++) {
+			tokens.push_back(index.tokens[i]);
+			char c = *index.tokens[i];
+			if (i != first && (c == '[' || c == '{') && index.close[i] != lazy_index::unmatched) {
+				i = index.close[i];
+				tokens.push_back(index.tokens[i]);
+			}
+		}
+		// strings past a control character are invalid, as when indexing the level on its own
+		auto control = first < last ? std::lower_bound(index.controls.begin(), index.controls.end(), index.tokens[first]) : index.controls.end();
+		reader r { std::move(tokens), index.end, control == index.controls.end() ? index.end : *control };
+		builder b { nullptr, true, key_pool::current(), true, &index };
+		return b.consume(r);
+	}
+	
+	template <typename R> static aeon const & build(R && r, document & doc, size_t arena_size, bool borrow) {
+		doc.m_root = aeon {};
+		doc.m_arena = std::make_unique<std::pmr::monotonic_buffer_resource>(std::max<size_t>(4096, arena_size));
+		
+		builder b { doc.m_arena.get(), borrow };
+		doc.m_root = b.consume(r);
+		return doc.m_root;
+	}
+};
+
+// arenas are sized so that typical documents fit in the first upstream allocation
+
+aeon aeon::deserialize_json(char const * cur, char const * end) {
+	return builder::build(reader { cur, end }, false);
+}
+
+aeon aeon::deserialize_json(char const * cur, char const * end, limits const & lim) {
+	return builder::build(reader { cur, end, lim }, false);
+}
+
+aeon const & aeon::deserialize_json(char const * cur, char const * end, document & doc, limits const & lim) {
+	return builder::build(reader { cur, end, lim }, doc, (end - cur) * 3, false);
+}
+
+void aeon::validate_json(char const * cur, char const * end, limits const & lim) {
+	reader r { cur, end, lim };
+	r.m_convert = false;
+	while (r.next());
+}
+
+aeon aeon::deserialize_json_lazy(char const * cur, char const * end) {
+	return builder::build_lazy(cur, end);
+}
+
+// the brackets were matched when the input was indexed, the contents are only checked now
+void aeon::materialize() const {
+	aeon & self = const_cast<aeon &>(*this);
+	self = builder::build_level(*m_index, m_len, m_index->close[m_len] + size_t(1));
+}
+
+aeon const & aeon::deserialize_json(char const * cur, char const * end, document & doc) {
+	return builder::build(reader { cur, end }, doc, (end - cur) * 3, false);
+}
+
+aeon aeon::deserialize_json_borrowed(char const * cur, char const * end) {
+	return builder::build(reader { cur, end }, true);
+}
+
+aeon const & aeon::deserialize_json_borrowed(char const * cur, char const * end, document & doc) {
+	return builder::build(reader { cur, end }, doc, (end - cur) * 2, true);
+}
+
+void aeon::deserialize_json(char const * cur, char const * end, handler & h) {
+	reader r { cur, end };
+	while (r.next()) switch (r.event()) {
+		case event_t::none: break;
+		case event_t::null: h.null(); break;
+		case event_t::boolean: h.boolean(r.boolean()); break;
+		case event_t::integer: h.integer(r.integer()); break;
+		case event_t::floating: h.floating(r.floating()); break;
+		case event_t::string: h.string(r.string()); break;
+		case event_t::key: h.key(r.string()); break;
+		case event_t::start_array: h.start_array(); break;
+		case event_t::end_array: h.end_array(); break;
+		case event_t::start_map: h.start_map(); break;
+		case event_t::end_map: h.end_map(); break;
+	}
+}
+
+// ----------------
+// DESERIALIZE BINARY
+// ----------------
+
+namespace {
+	
+	// Decodes CBOR into the same events as aeon::reader, so that the tree builder can consume either.
+	struct cbor_reader {
+		
+		using event_t = aeon::event_t;
+		
+		struct frame {
+			uint64_t remaining; // items left, keys and values counted separately for maps
+			bool map;
+		};
+		
+		char const * cur;
+		char const * end;
+		std::vector<frame> stack {};
+		bool started = false;
+		
+		event_t m_event = event_t::none;
+		bool m_bool = false;
+		aeon::int_t m_int = 0;
+		aeon::flt_t m_flt = 0;
+		std::string_view m_str {};
+		
+		inline event_t event() const { return m_event; }
+		inline bool boolean() const { return m_bool; }
+		inline aeon::int_t integer() const { return m_int; }
+		inline aeon::flt_t floating() const { return m_flt; }
+		inline std::string_view string() const { return m_str; }
+		inline bool borrowed() const { return true; }
+		
+		uint64_t read_be(size_t n) {
+			if (static_cast<size_t>(end - cur) < n) throw_eoi;
+			uint64_t v = 0;
+			for (size_t i = 0; i < n; i++) v = v << 8 | static_cast<uint8_t>(*cur++);
+			return v;
+		}
+		
+		static aeon::flt_t half(uint16_t h) {
+			int exp = (h >> 10) & 0x1F;
+			int mant = h & 0x3FF;
+			aeon::flt_t v;
+			if (exp == 0) v = std::ldexp(mant, -24);
+			else if (exp != 31) v = std::ldexp(mant + 1024, exp - 25);
+			else v = mant ? std::numeric_limits<aeon::flt_t>::quiet_NaN() : std::numeric_limits<aeon::flt_t>::infinity();
+			return h & 0x8000 ? -v : v;
+		}
+		
+		bool next() {
+			if (started && stack.empty()) {
+				m_event = event_t::none;
+				return false;
+			}
+			started = true;
+			
+			if (!stack.empty() && !stack.back().remaining) {
+				m_event = stack.back().map ? event_t::end_map : event_t::end_array;
+				stack.pop_back();
+				return true;
+			}
+			
+			bool is_key = false;
+			if (!stack.empty()) {
+				is_key = stack.back().map && !(stack.back().remaining % 2);
+				stack.back().remaining--;
+			}
+			
+			for (;;) {
+				if (cur == end) throw_eoi;
+				uint8_t initial = *cur++;
+				uint8_t major = initial >> 5;
+				uint8_t info = initial & 0x1F;
+				if (info > 27) throw aeon::deserialize_exception {"unsupported CBOR item"};
+				uint64_t arg = info < 24 ? info : read_be(1 << (info - 24));
+				if (is_key && major != 2 && major != 3 && major != 6) throw aeon::deserialize_exception {"map keys must be strings"};
+				
+				switch (major) {
+					// integers beyond int_t are read as floating values, as in JSON
+					case 0:
+						if (arg <= static_cast<uint64_t>(std::numeric_limits<aeon::int_t>::max())) {
+							m_int = arg;
+							m_event = event_t::integer;
+						} else {
+							m_flt = arg;
+							m_event = event_t::floating;
+						}
+						return true;
+					case 1:
+						if (arg <= static_cast<uint64_t>(std::numeric_limits<aeon::int_t>::max())) {
+							m_int = -1 - static_cast<aeon::int_t>(arg);
+							m_event = event_t::integer;
+						} else {
+							m_flt = -1.0 - static_cast<aeon::flt_t>(arg);
+							m_event = event_t::floating;
+						}
+						return true;
+					case 2: case 3:
+						if (arg > static_cast<uint64_t>(end - cur)) throw_eoi;
+						m_str = { cur, static_cast<size_t>(arg) };
+						cur += arg;
+						m_event = is_key ? event_t::key : event_t::string;
+						return true;
+					case 4: case 5:
+						// every item takes at least a byte, which bounds a corrupt count before it is trusted
+						if (arg > static_cast<uint64_t>(end - cur)) throw_eoi;
+						stack.push_back({ major == 5 ? arg * 2 : arg, major == 5 });
+						m_event = major == 5 ? event_t::start_map : event_t::start_array;
+						return true;
+					case 6:
+						continue; // the tagged item follows
+					case 7:
+						switch (info) {
+							case 20: case 21: m_bool = info == 21; m_event = event_t::boolean; return true;
+							case 22: case 23: m_event = event_t::null; return true;
+							case 25: m_flt = half(arg); m_event = event_t::floating; return true;
+							case 26: m_flt = std::bit_cast<float>(static_cast<uint32_t>(arg)); m_event = event_t::floating; return true;
+							case 27: m_flt = std::bit_cast<double>(arg); m_event = event_t::floating; return true;
+							default: throw aeon::deserialize_exception {"unsupported CBOR item"};
+						}
+				}
+			}
+		}
+	};
+}
+
+aeon aeon::deserialize_binary(char const * cur, char const * end) {
+	return builder::build(cbor_reader { cur, end }, false);
+}
+
+aeon const & aeon::deserialize_binary(char const * cur, char const * end, document & doc) {
+	return builder::build(cbor_reader { cur, end }, doc, (end - cur) * 3, false);
+}
+
+// ----------------
+// INCREMENTAL
+// ----------------
+
+// The parser only tracks enough state to find where each top-level value ends, the value itself is then parsed in one go.
+size_t aeon::parser::feed(char const * data, size_t size) {
+	char const * cur = data;
+	char const * end = data + size;
+	char const * begin = data; // start of the value in progress within this piece
+	size_t completed = 0;
+	
+	auto close = [&](char const * value_end){
+		complete(begin, value_end);
+		m_state = state_t::between;
+		completed++;
+	};
+	
+	try {
+		for (; cur != end; cur++) {
+			char c = *cur;
+			switch (m_state) {
+				case state_t::scalar:
+					if (json_is_scalar_char(c)) continue;
+					close(cur);
+					[[fallthrough]]; // the terminating character belongs to whatever follows
+				case state_t::between:
+					if (json_class_table[static_cast<uint8_t>(c)] & jc_whitespace) continue;
+					begin = cur;
+					switch (c) {
+						case '"': m_state = state_t::string; continue;
+						case '[': case '{': m_depth = 1; m_state = state_t::container; continue;
+						default:
+							if (!json_is_scalar_char(c)) throw_ii;
+							m_state = state_t::scalar;
+							continue;
+					}
+				case state_t::string:
+					while (cur != end && *cur != '"' && *cur != '\\') cur++;
+					if (cur == end) { cur--; continue; }
+					if (*cur == '\\') m_state = state_t::escape;
+					else if (m_depth) m_state = state_t::container;
+					else close(cur + 1);
+					continue;
+				case state_t::escape:
+					m_state = state_t::string;
+					continue;
+				case state_t::container:
+					switch (c) {
+						case '"': m_state = state_t::string; continue;
+						case '[': case '{': m_depth++; continue;
+						case ']': case '}': if (!--m_depth) close(cur + 1); continue;
+						default: continue;
+					}
+			}
+		}
+	} catch (...) {
+		abandon();
+		throw;
+	}
+	
+	if (m_state != state_t::between) m_pending.append(begin, end);
+	return completed;
+}
+
+void aeon::parser::finish() {
+	switch (m_state) {
+		case state_t::between: return;
+		case state_t::scalar:
+			try {
+				complete(nullptr, nullptr);
+			} catch (...) {
+				abandon();
+				throw;
+			}
+			m_state = state_t::between;
+			return;
+		default:
+			abandon();
+			throw_eoi;
+	}
+}
+
+// values contained entirely within one piece are parsed in place, the rest are assembled in the pending buffer first
+void aeon::parser::complete(char const * begin, char const * end) {
+	if (m_pending.empty()) {
+		m_values.push_back(deserialize_json(begin, end));
+		return;
+	}
+	m_pending.append(begin, end);
+	aeon value = deserialize_json(m_pending);
+	m_pending.clear();
+	m_values.push_back(std::move(value));
+}
+
+// discards the value in progress, keeping those already completed
+void aeon::parser::abandon() {
+	m_pending.clear();
+	m_depth = 0;
+	m_state = state_t::between;
+}
+
+aeon aeon::parser::pop() {
+	aeon value = std::move(m_values.front());
+	m_values.pop_front();
+	return value;
+}
+
+void aeon::parser::clear() {
+	m_values.clear();
+	m_pending = {};
+	m_depth = 0;
+	m_state = state_t::between;
+}
+
+// ----------------
+// NDJSON
+// ----------------
+
+namespace {
+	
+	struct mapped_file {
+		void * data = MAP_FAILED;
+		size_t size = 0;
+		
+		mapped_file(char const * path, int advice) {
+			int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+			if (fd < 0) throw std::system_error { errno, std::generic_category(), path };
+			struct stat st;
+			if (::fstat(fd, &st)) {
+				int err = errno;
+				::close(fd);
+				throw std::system_error { err, std::generic_category(), path };
+			}
+			size = st.st_size;
+			if (size) data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			int err = errno;
+			::close(fd);
+			if (size && data == MAP_FAILED) throw std::system_error { err, std::generic_category(), path };
+			if (size) ::madvise(data, size, advice);
+		}
+		
+		~mapped_file() { if (data != MAP_FAILED) ::munmap(data, size); }
+		mapped_file(mapped_file const &) = delete;
+		
+		std::string_view view() const { return size ? std::string_view { reinterpret_cast<char const *>(data), size } : std::string_view {}; }
+	};
+}
+
+struct aeon::ndjson {
+	
+	struct chunk {
+		char const * begin;
+		char const * end;
+		std::vector<aeon> records {};
+		std::exception_ptr error {};
+		bool done = false;
+	};
+	
+	// each line must hold exactly one value, errors are reported with the offset of the line within the whole input
+	template <typename F> static void lines(char const * input, char const * cur, char const * end, F && fn) {
+		while (cur != end) {
+			char const * eol = reinterpret_cast<char const *>(std::memchr(cur, '\n', end - cur));
+			if (!eol) eol = end;
+			if (std::any_of(cur, eol, [](char c){ return !(json_class_table[static_cast<uint8_t>(c)] & jc_whitespace); })) {
+				reader r { cur, eol };
+				r.m_whole = true;
+				try {
+					fn(builder::build(r, false));
+				} catch (deserialize_exception const & e) {
+					throw deserialize_exception {std::string { e.what() } + " in the line at byte " + std::to_string(cur - input)};
+				}
+			}
+			cur = eol == end ? end : eol + 1;
+		}
+	}
+	
+	// Parses the chunks of str in parallel. With prefetch, str is a file mapping whose chunks are read ahead by madvise(2)
+	// as workers claim them, rather than the whole file up front.
+	static void parallel(std::string_view str, aeon::record_fn const & fn, unsigned threads, bool prefetch) {
+		if (!threads) threads = std::max(1u, std::thread::hardware_concurrency());
+		char const * begin = str.data();
+		char const * end = begin + str.size();
+		
+		// several chunks per thread so that uneven line lengths still balance out
+		size_t const chunk_size = std::max<size_t>(1 << 20, str.size() / (threads * 8) + 1);
+		std::vector<chunk> chunks;
+		for (char const * cur = begin; cur != end;) {
+			char const * stop = cur + std::min<size_t>(chunk_size, end - cur);
+			if (stop != end) {
+				stop = reinterpret_cast<char const *>(std::memchr(stop, '\n', end - stop));
+				stop = stop ? stop + 1 : end;
+			}
+			chunks.push_back({ cur, stop });
+			cur = stop;
+		}
+		
+		if (threads == 1 || chunks.size() <= 1) {
+			lines(begin, begin, end, fn);
+			return;
+		}
+		
+		// workers stay at most a window of chunks ahead of delivery, bounding the number of records held in memory
+		std::mutex mut;
+		std::condition_variable cv;
+		size_t const window = threads * 2;
+		size_t claimed = 0;
+		size_t delivered = 0;
+		bool abort = false;
+		
+		// workers intern keys into the caller's pool, if any
+		aeon::key_pool * keys = aeon::key_pool::current();
+		auto work = [&](){
+			std::optional<aeon::key_pool::scope> scope;
+			if (keys) scope.emplace(*keys);
+			std::unique_lock lk { mut };
+			for (;;) {
+				cv.wait(lk, [&](){ return abort || claimed == chunks.size() || claimed < delivered + window; });
+				if (abort || claimed == chunks.size()) return;
+				chunk & c = chunks[claimed++];
+				lk.unlock();
+				if (prefetch) {
+					static size_t const page = ::sysconf(_SC_PAGESIZE);
+					uintptr_t first = reinterpret_cast<uintptr_t>(c.begin) / page * page;
+					::madvise(reinterpret_cast<void *>(first), reinterpret_cast<uintptr_t>(c.end) - first, MADV_WILLNEED);
+				}
+				try {
+					lines(begin, c.begin, c.end, [&](aeon && v){ c.records.push_back(std::move(v)); });
+				} catch (...) {
+					c.error = std::current_exception();
+				}
+				lk.lock();
+				c.done = true;
+				cv.notify_all();
+			}
+		};
+		
+		std::vector<std::thread> pool;
+		size_t const workers = std::min<size_t>(threads, chunks.size());
+		pool.reserve(workers);
+		for (size_t i = 0; i < workers; i++) pool.emplace_back(work);
+		auto join = [&](){
+			{ std::lock_guard lk { mut }; abort = true; }
+			cv.notify_all();
+			for (std::thread & t : pool) t.join();
+		};
+		
+		try {
+			for (chunk & c : chunks) {
+				{
+					std::unique_lock lk { mut };
+					cv.wait(lk, [&](){ return c.done; });
+				}
+				// a finished chunk is no longer touched by its worker
+				for (aeon & v : c.records) fn(std::move(v));
+				c.records = {};
+				if (c.error) std::rethrow_exception(c.error);
+				{ std::lock_guard lk { mut }; delivered++; }
+				cv.notify_all();
+			}
+		} catch (...) {
+			join();
+			throw;
+		}
+		join();
+	}
+};
+
+void aeon::deserialize_ndjson(std::string_view str, record_fn const & fn, unsigned threads) {
+	ndjson::parallel(str, fn, threads, false);
+}
+
+std::vector<aeon> aeon::deserialize_ndjson(std::string_view str, unsigned threads) {
+	std::vector<aeon> records;
+	deserialize_ndjson(str, [&](aeon && v){ records.push_back(std::move(v)); }, threads);
+	return records;
+}
+
+void aeon::deserialize_ndjson_file(char const * path, record_fn const & fn, unsigned threads) {
+	mapped_file file { path, MADV_SEQUENTIAL };
+	ndjson::parallel(file.view(), fn, threads, true);
+}
+
+std::vector<aeon> aeon::deserialize_ndjson_file(char const * path, unsigned threads) {
+	std::vector<aeon> records;
+	deserialize_ndjson_file(path, [&](aeon && v){ records.push_back(std::move(v)); }, threads);
+	return records;
+}
+
+// ----------------
+// FROZEN
+// ----------------
+
+// Image layout, every part of it 8 byte aligned:
+//   header: magic, total image size, root slot
+//   slot: type, 3 bytes padding, count (string length or element count), payload (scalar, inline string, or data offset)
+//   string: its bytes followed by a terminating zero, unless stored inline
+//   array: count element slots
+//   map: count key slots sorted by key, then count value slots in the same order
+
+namespace {
+	
+	constexpr uint64_t frozen_magic = 0x315A52464E4F4541; // "AEONFRZ1"
+	constexpr size_t frozen_header_size = 32;
+	constexpr size_t frozen_inline_max = 8;
+	constexpr size_t frozen_max_depth = 1024;
+	
+	struct frozen_slot {
+		uint8_t type = 0;
+		uint8_t padding [3] {};
+		uint32_t count = 0;
+		uint64_t payload = 0;
+	};
+	static_assert(sizeof(frozen_slot) == 16);
+	
+	constexpr frozen_slot frozen_null {};
+	
+	inline frozen_slot load_slot(char const * p) {
+		frozen_slot s;
+		std::memcpy(&s, p, sizeof(s));
+		return s;
+	}
+	
+	[[noreturn]] void throw_corrupt() {
+		throw aeon::deserialize_exception {"corrupt frozen image"};
+	}
+	
+	struct freezer {
+		std::string out;
+		
+		inline size_t reserve(size_t n) {
+			size_t off = out.size();
+			out.resize(off + ((n + 7) & ~size_t(7)));
+			return off;
+		}
+		
+		inline void store(size_t off, frozen_slot const & s) {
+			std::memcpy(out.data() + off, &s, sizeof(s));
+		}
+		
+		static uint32_t count_of(size_t n) {
+			if (n > std::numeric_limits<uint32_t>::max()) throw std::length_error {"aeon::serialize_frozen: value too large"};
+			return static_cast<uint32_t>(n);
+		}
+		
+		frozen_slot place_string(std::string_view str) {
+			frozen_slot s;
+			s.type = static_cast<uint8_t>(aeon::type_t::string);
+			s.count = count_of(str.size());
+			if (str.size() <= frozen_inline_max) {
+				std::memcpy(&s.payload, str.data(), str.size());
+			} else {
+				s.payload = reserve(str.size() + 1);
+				std::memcpy(out.data() + s.payload, str.data(), str.size());
+			}
+			return s;
+		}
+		
+		frozen_slot place(aeon const & v, size_t depth = 0) {
+			frozen_slot s;
+			s.type = static_cast<uint8_t>(v.type());
+			if ((v.is_array() || v.is_map()) && depth >= frozen_max_depth) throw std::length_error {"aeon::serialize_frozen: nested too deeply"};
+			switch (v.type()) {
+				case aeon::type_t::nul: break;
+				case aeon::type_t::boolean: s.payload = v.boolean(); break;
+				case aeon::type_t::integer: s.payload = static_cast<uint64_t>(v.integer()); break;
+				case aeon::type_t::floating: s.payload = std::bit_cast<uint64_t>(v.floating()); break;
+				case aeon::type_t::string: return place_string(v.string());
+				case aeon::type_t::array: {
+					aeon::ary_t const & ary = v.array();
+					s.count = count_of(ary.size());
+					s.payload = reserve(ary.size() * sizeof(frozen_slot));
+					for (size_t i = 0; i < ary.size(); i++) {
+						frozen_slot e = place(ary[i], depth + 1);
+						store(s.payload + i * sizeof(frozen_slot), e);
+					}
+					break;
+				}
+				case aeon::type_t::map: {
+					aeon::map_t const & map = v.map();
+					std::vector<aeon::map_t::value_type const *> sorted;
+					sorted.reserve(map.size());
+					for (auto const & e : map) sorted.push_back(&e);
+					std::sort(sorted.begin(), sorted.end(), [](auto a, auto b){ return a->first.view() < b->first.view(); });
+					
+					s.count = count_of(map.size());
+					s.payload = reserve(2 * map.size() * sizeof(frozen_slot));
+					size_t values = s.payload + map.size() * sizeof(frozen_slot);
+					// keys are all placed ahead of the values so that lookups touch as few pages as possible
+					for (size_t i = 0; i < sorted.size(); i++) {
+						frozen_slot k = place_string(sorted[i]->first.view());
+						store(s.payload + i * sizeof(frozen_slot), k);
+					}
+					for (size_t i = 0; i < sorted.size(); i++) {
+						frozen_slot e = place(sorted[i]->second, depth + 1);
+						store(values + i * sizeof(frozen_slot), e);
+					}
+					break;
+				}
+			}
+			return s;
+		}
+		
+		void freeze(aeon const & root) {
+			reserve(frozen_header_size);
+			frozen_slot s = place(root);
+			uint64_t size = out.size();
+			std::memcpy(out.data(), &frozen_magic, 8);
+			std::memcpy(out.data() + 8, &size, 8);
+			store(16, s);
+		}
+	};
+}
+
+std::string aeon::serialize_frozen() const {
+	freezer f;
+	f.freeze(*this);
+	return std::move(f.out);
+}
+
+void aeon::serialize_frozen(sink_fn sink, void * ctx) const {
+	std::string image = serialize_frozen();
+	sink(ctx, image.data(), image.size());
+}
+
+void aeon::serialize_frozen(buffer & buf) const {
+	serialize_frozen(&buffer_sink, &buf);
+}
+
+void aeon::serialize_frozen(int fd) const {
+	serialize_frozen(&fd_sink, &fd);
+}
+
+aeon::frozen::frozen(std::string_view image) : m_image(image) {
+	uint64_t magic, size;
+	if (image.size() < frozen_header_size) throw_corrupt();
+	std::memcpy(&magic, image.data(), 8);
+	std::memcpy(&size, image.data() + 8, 8);
+	if (magic != frozen_magic || size > image.size()) throw_corrupt();
+	m_image = image.substr(0, size);
+}
+
+aeon::frozen aeon::frozen::open(char const * path) {
+	auto file = std::make_shared<mapped_file const>(path, MADV_NORMAL);
+	frozen f { file->view() };
+	f.m_mapping = std::move(file);
+	return f;
+}
+
+aeon::frozen::value aeon::frozen::root() const {
+	return { m_image, m_image.data() + 16 };
+}
+
+// payloads are always placed after the slot referring to them, which rules out cycles in a corrupt image
+char const * aeon::frozen::value::block(uint64_t offset, size_t bytes) const {
+	size_t after = static_cast<size_t>(m_slot - m_image.data()) + sizeof(frozen_slot);
+	if (offset < after || offset > m_image.size() || bytes > m_image.size() - offset) throw_corrupt();
+	return m_image.data() + offset;
+}
+
+aeon::type_t aeon::frozen::value::type() const {
+	uint8_t t = static_cast<uint8_t>(*m_slot);
+	if (t > static_cast<uint8_t>(type_t::map)) throw_corrupt();
+	return static_cast<type_t>(t);
+}
+
+size_t aeon::frozen::value::size() const {
+	frozen_slot s = load_slot(m_slot);
+	switch (type()) {
+		case type_t::nul: return 0;
+		case type_t::string:
+		case type_t::array:
+		case type_t::map: return s.count;
+		default: return 1;
+	}
+}
+
+bool aeon::frozen::value::boolean() const {
+	return is_bool() && load_slot(m_slot).payload;
+}
+
+aeon::int_t aeon::frozen::value::integer() const {
+	return is_integer() ? static_cast<int_t>(load_slot(m_slot).payload) : 0;
+}
+
+aeon::flt_t aeon::frozen::value::floating() const {
+	return is_floating() ? std::bit_cast<flt_t>(load_slot(m_slot).payload) : 0.0;
+}
+
+std::string_view aeon::frozen::value::string() const {
+	if (!is_string()) return {};
+	frozen_slot s = load_slot(m_slot);
+	if (s.count <= frozen_inline_max) return { m_slot + offsetof(frozen_slot, payload), s.count };
+	return { block(s.payload, s.count), s.count };
+}
+
+aeon::frozen::value aeon::frozen::value::operator [] (size_t i) const {
+	frozen_slot s = load_slot(m_slot);
+	if (!is_array() || i >= s.count) return { m_image, reinterpret_cast<char const *>(&frozen_null) };
+	return { m_image, block(s.payload, s.count * sizeof(frozen_slot)) + i * sizeof(frozen_slot) };
+}
+
+aeon::frozen::value aeon::frozen::value::operator [] (std::string_view key) const {
+	frozen_slot s = load_slot(m_slot);
+	if (!is_map()) return { m_image, reinterpret_cast<char const *>(&frozen_null) };
+	char const * slots = block(s.payload, 2 * size_t(s.count) * sizeof(frozen_slot));
+	size_t lo = 0, hi = s.count;
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		char const * k = slots + mid * sizeof(frozen_slot);
+		uint32_t len;
+		uint64_t data;
+		std::memcpy(&len, k + offsetof(frozen_slot, count), sizeof(len));
+		std::memcpy(&data, k + offsetof(frozen_slot, payload), sizeof(data));
+		std::string_view kv { len <= frozen_inline_max ? k + offsetof(frozen_slot, payload) : block(data, len), len };
+		int cmp = kv.compare(key);
+		if (!cmp) return { m_image, slots + (s.count + mid) * sizeof(frozen_slot) };
+		if (cmp < 0) lo = mid + 1;
+		else hi = mid;
+	}
+	return { m_image, reinterpret_cast<char const *>(&frozen_null) };
+}
+
+bool aeon::frozen::value::contains(std::string_view key) const {
+	return (*this)[key].m_slot != reinterpret_cast<char const *>(&frozen_null);
+}
+
+std::pair<std::string_view, aeon::frozen::value> aeon::frozen::value::entry(size_t i) const {
+	frozen_slot s = load_slot(m_slot);
+	if (!is_map() || i >= s.count) return { {}, { m_image, reinterpret_cast<char const *>(&frozen_null) } };
+	char const * slots = block(s.payload, 2 * size_t(s.count) * sizeof(frozen_slot));
+	return { value { m_image, slots + i * sizeof(frozen_slot) }.string(), { m_image, slots + (s.count + i) * sizeof(frozen_slot) } };
+}
+
+aeon aeon::frozen::value::thaw() const {
+	return thaw(0);
+}
+
+aeon aeon::frozen::value::thaw(size_t depth) const {
+	if ((is_array() || is_map()) && depth >= frozen_max_depth) throw_corrupt();
+	switch (type()) {
+		case type_t::nul: return aeon {};
+		case type_t::boolean: return aeon { boolean() };
+		case type_t::integer: return aeon { integer() };
+		case type_t::floating: return aeon { floating() };
+		case type_t::string: return aeon { string() };
+		case type_t::array: {
+			aeon ret;
+			ary_t & ary = ret.array();
+			size_t n = size();
+			ary.reserve(n);
+			for (size_t i = 0; i < n; i++) ary.push_back((*this)[i].thaw(depth + 1));
+			return ret;
+		}
+		case type_t::map: {
+			aeon ret;
+			map_t & map = ret.map();
+			size_t n = size();
+			map.reserve(n);
+			for (size_t i = 0; i < n; i++) {
+				auto [key, v] = entry(i);
+				map.try_emplace(key, v.thaw(depth + 1));
+			}
+			return ret;
+		}
+	}
+	return aeon {};
+}
+
+// ----------------
+// KEY POOL
+// ----------------
+
+// Keys are spread over shards by the top bits of their hash, each an open addressed table of handles under its own
+// reader/writer lock, with the key bytes themselves kept in a per-shard arena so that handles stay valid as tables grow.
+struct aeon::key_pool::shard {
+	std::shared_mutex mut;
+	std::pmr::monotonic_buffer_resource bytes;
+	std::vector<key_t> table = std::vector<key_t>(64);
+	size_t count = 0;
+	
+	key_t const * find(std::string_view key, uint32_t hash) const {
+		size_t mask = table.size() - 1;
+		for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+			key_t const & k = table[slot];
+			if (!k.data()) return nullptr;
+			if (k.hash() == hash && k.view() == key) return &k;
+		}
+	}
+	
+	static void place(std::vector<key_t> & table, key_t const & key) {
+		size_t mask = table.size() - 1;
+		size_t slot = key.hash() & mask;
+		while (table[slot].data()) slot = (slot + 1) & mask;
+		table[slot] = key;
+	}
+	
+	key_t insert(std::string_view key, uint32_t hash) {
+		if ((count + 1) * 2 > table.size()) {
+			std::vector<key_t> grown (table.size() * 2);
+			for (key_t const & k : table) if (k.data()) place(grown, k);
+			table = std::move(grown);
+		}
+		char * data = reinterpret_cast<char *>(bytes.allocate(key.size() ? key.size() : 1, 1));
+		std::memcpy(data, key.data(), key.size());
+		key_t k = key_t::make_interned(data, key.size(), hash);
+		place(table, k);
+		count++;
+		return k;
+	}
+};
+
+namespace {
+	
+	struct key_cache_entry {
+		uint64_t pool;
+		aeon::key_t key;
+	};
+	
+	std::atomic_uint64_t next_pool_id {1};
+	
+	// pools are identified by a never reused id rather than address, so a destroyed pool cannot be mistaken for a new one
+	thread_local std::array<key_cache_entry, 256> key_cache {};
+	thread_local aeon::key_pool * current_pool = nullptr;
+}
+
+aeon::key_pool::key_pool() : m_id(next_pool_id++), m_shards(new shard [SHARD_COUNT]) {}
+aeon::key_pool::~key_pool() = default;
+
+aeon::key_t aeon::key_pool::intern(std::string_view key) {
+	uint32_t hash = key_t::hash_of(key);
+	key_cache_entry & cached = key_cache[hash % key_cache.size()];
+	if (cached.pool == m_id && cached.key.hash() == hash && cached.key.view() == key) return cached.key;
+	
+	shard & s = m_shards[hash >> 28];
+	key_t ret;
+	bool found;
+	{
+		std::shared_lock lk { s.mut };
+		key_t const * k = s.find(key, hash);
+		if ((found = k)) ret = *k;
+	}
+	if (!found) {
+		std::unique_lock lk { s.mut };
+		key_t const * k = s.find(key, hash);
+		ret = k ? *k : s.insert(key, hash);
+	}
+	
+	cached = { m_id, ret };
+	return ret;
+}
+
+size_t aeon::key_pool::size() const {
+	size_t total = 0;
+	for (size_t i = 0; i < SHARD_COUNT; i++) {
+		std::shared_lock lk { m_shards[i].mut };
+		total += m_shards[i].count;
+	}
+	return total;
+}
+
+aeon::key_pool::scope::scope(key_pool & pool) : m_previous(current_pool) {
+	current_pool = &pool;
+}
+
+aeon::key_pool::scope::~scope() {
+	current_pool = m_previous;
+}
+
+aeon::key_pool * aeon::key_pool::current() {
+	return current_pool;
+}
+
+// ----------------
+// PATHS
+// ----------------
+
+namespace {
+	
+	// Unescapes the segments of a JSON Pointer into text, returning the end of each within it and whether it was "*".
+	std::vector<std::pair<size_t, bool>> split_pointer(std::string_view pointer, std::string & text) {
+		if (!pointer.empty() && pointer[0] != '/') throw std::invalid_argument {"aeon::path: pointer must be empty or begin with '/'"};
+		
+		text.reserve(text.size() + pointer.size());
+		std::vector<std::pair<size_t, bool>> spans;
+		for (size_t pos = 0; pos < pointer.size();) {
+			size_t end = pointer.find('/', pos + 1);
+			if (end == std::string_view::npos) end = pointer.size();
+			std::string_view raw = pointer.substr(pos + 1, end - pos - 1);
+			for (size_t i = 0; i < raw.size(); i++) {
+				if (raw[i] != '~') {
+					text.push_back(raw[i]);
+					continue;
+				}
+				switch (i + 1 < raw.size() ? raw[++i] : 0) {
+					case '0': text.push_back('~'); break;
+					case '1': text.push_back('/'); break;
+					case '2': text.push_back('*'); break;
+					default: throw std::invalid_argument {"aeon::path: invalid escape"};
+				}
+			}
+			spans.emplace_back(text.size(), raw == "*");
+			pos = end;
+		}
+		return spans;
+	}
+	
+	// array indices are plain decimal without leading zeros, anything else (including "-") is npos
+	size_t pointer_index(std::string_view str) {
+		if (str.empty() || (str.size() > 1 && str[0] == '0')) return std::string_view::npos;
+		if (!std::all_of(str.begin(), str.end(), [](char c){ return c >= '0' && c <= '9'; })) return std::string_view::npos;
+		size_t index;
+		if (std::from_chars(str.data(), str.data() + str.size(), index).ec != std::errc {}) return std::string_view::npos;
+		return index;
+	}
+}
+
+aeon::path::path(std::string_view pointer) {
+	auto text = std::make_shared<std::string>();
+	size_t begin = 0;
+	for (auto [end, any] : split_pointer(pointer, *text)) {
+		std::string_view str { text->data() + begin, end - begin };
+		m_segments.push_back(segment { key_t::make_external(str), pointer_index(str), any });
+		m_wildcard = m_wildcard || any;
+		begin = end;
+	}
+	m_text = std::move(text);
+}
+
+aeon const * aeon::path::step(aeon const & v, segment const & s) {
+	if (v.is_map()) {
+		auto const & map = v.map();
+		auto i = map.find(s.key);
+		return i == map.end() ? nullptr : &i->second;
+	}
+	if (v.is_array() && s.index < v.array().size()) return &v.array()[s.index];
+	return nullptr;
+}
+
+aeon const * aeon::path::first(aeon const & v, size_t depth) const {
+	if (depth == m_segments.size()) return &v;
+	segment const & s = m_segments[depth];
+	if (!s.any) {
+		aeon const * next = step(v, s);
+		return next ? first(*next, depth + 1) : nullptr;
+	}
+	if (v.is_array()) {
+		for (aeon const & e : v.array()) if (aeon const * found = first(e, depth + 1)) return found;
+	} else if (v.is_map()) {
+		for (auto const & [key, e] : v.map()) if (aeon const * found = first(e, depth + 1)) return found;
+	}
+	return nullptr;
+}
+
+aeon const * aeon::path::find(aeon const & root) const {
+	if (m_wildcard) return first(root, 0);
+	aeon const * cur = &root;
+	for (segment const & s : m_segments) if (!(cur = step(*cur, s))) return nullptr;
+	return cur;
+}
+
+void aeon::path::find(aeon const * docs, size_t count, aeon const ** results) const {
+	if (m_wildcard) {
+		for (size_t i = 0; i < count; i++) results[i] = find(docs[i]);
+		return;
+	}
+	for (size_t i = 0; i < count; i++) results[i] = &docs[i];
+	for (segment const & s : m_segments) {
+		for (size_t i = 0; i < count; i++) {
+			if (!results[i]) continue;
+			aeon const * next = step(*results[i], s);
+			if (next && (next->m_type == type_t::map || next->m_type == type_t::array)) __builtin_prefetch(next->m_map);
+			results[i] = next;
+		}
+	}
+}
+
+namespace {
+	
+	// presents the value at the reader's current event as a complete input, for building a tree from part of a stream
+	struct subtree_reader {
+		aeon::reader & r;
+		size_t depth = 0;
+		bool started = false;
+		
+		inline bool next() {
+			if (started) {
+				if (!depth) return false;
+				r.next();
+			}
+			started = true;
+			switch (r.event()) {
+				case aeon::event_t::start_array:
+				case aeon::event_t::start_map: depth++; break;
+				case aeon::event_t::end_array:
+				case aeon::event_t::end_map: depth--; break;
+				default: break;
+			}
+			return true;
+		}
+		
+		inline aeon::event_t event() const { return r.event(); }
+		inline bool boolean() const { return r.boolean(); }
+		inline aeon::int_t integer() const { return r.integer(); }
+		inline aeon::flt_t floating() const { return r.floating(); }
+		inline std::string_view string() const { return r.string(); }
+		inline bool borrowed() const { return r.borrowed(); }
+	};
+}
+
+// returns true once parsing can stop
+bool aeon::path::select(reader & r, size_t depth, record_fn const & fn) const {
+	if (depth == m_segments.size()) {
+		fn(builder::build(subtree_reader { r }, false));
+		return !m_wildcard;
+	}
+	
+	segment const & s = m_segments[depth];
+	if (r.event() == event_t::start_map) {
+		while (r.next() && r.event() == event_t::key) {
+			bool match = s.any || r.string() == s.key.view();
+			r.next();
+			if (!match) r.skip();
+			else if (select(r, depth + 1, fn)) return true;
+		}
+	} else if (r.event() == event_t::start_array) {
+		for (size_t i = 0; r.next() && r.event() != event_t::end_array; i++) {
+			if (!s.any && i != s.index) r.skip();
+			else if (select(r, depth + 1, fn)) return true;
+		}
+	}
+	return false;
+}
+
+void aeon::path::select_json(std::string_view json, record_fn const & fn) const {
+	reader r { json };
+	if (r.next()) select(r, 0, fn);
+}
+
+// ----------------
+// DIFF AND PATCH
+// ----------------
+
+namespace {
+	
+	inline uint64_t hash_mix(uint64_t h) {
+		h ^= h >> 30;
+		h *= 0xBF58476D1CE4E5B9;
+		h ^= h >> 27;
+		h *= 0x94D049BB133111EB;
+		return h ^ (h >> 31);
+	}
+	
+	// array elements are combined in order, map entries by a sum so that their order does not matter
+	template <typename F> uint64_t structural_hash(aeon const & v, F && child) {
+		switch (v.type()) {
+			case aeon::type_t::nul: return hash_mix(1);
+			case aeon::type_t::boolean: return hash_mix(2 + v.boolean());
+			case aeon::type_t::integer: return hash_mix(hash_mix(4) ^ static_cast<uint64_t>(v.integer()));
+			case aeon::type_t::floating: {
+				aeon::flt_t f = v.floating();
+				if (f == 0) f = 0; // -0.0 == 0.0
+				return hash_mix(hash_mix(5) ^ std::bit_cast<uint64_t>(f));
+			}
+			case aeon::type_t::string: return hash_mix(hash_mix(6) ^ std::hash<std::string_view> {} (v.string()));
+			case aeon::type_t::array: {
+				uint64_t h = hash_mix(7);
+				for (aeon const & e : v.array()) h = hash_mix(h + child(e));
+				return h;
+			}
+			case aeon::type_t::map: {
+				uint64_t h = v.map().size();
+				for (auto const & [key, e] : v.map()) h += hash_mix(std::hash<std::string_view> {} (key) ^ hash_mix(child(e)));
+				return hash_mix(hash_mix(8) ^ h);
+			}
+		}
+		return 0;
+	}
+	
+}
+
+// hashes of both trees are computed afresh before diffing, the cached ones are then valid throughout
+struct aeon::differ {
+	ary_t & ops;
+	std::string path {};
+	
+	static bool same(aeon const & a, aeon const & b) {
+		if (a.type() != b.type()) return false;
+		if (!a.is_array() && !a.is_map()) return a == b;
+		// hashes can collide, a match is only a shortcut past the comparison when they differ
+		return a.cached_hash() == b.cached_hash() && a == b;
+	}
+	
+	void append_key(std::string_view key) {
+		path.push_back('/');
+		for (char c : key) switch (c) {
+			case '~': path += "~0"; break;
+			case '/': path += "~1"; break;
+			default: path.push_back(c);
+		}
+	}
+	
+	void append_index(size_t i) {
+		char buf [number_buffer_size];
+		path.push_back('/');
+		path.append(buf, std::to_chars(buf, buf + sizeof(buf), i).ptr - buf);
+	}
+	
+	void op(std::string_view name, aeon const * value = nullptr) {
+		map_t & m = ops.emplace_back().map();
+		m.try_emplace("op", name);
+		m.try_emplace("path", path);
+		if (value) m.try_emplace("value", *value);
+	}
+	
+	void diff(aeon const & a, aeon const & b) {
+		if (a.type() != b.type() || (!a.is_array() && !a.is_map())) {
+			if (!(a == b)) op("replace", &b);
+			return;
+		}
+		if (a.cached_hash() == b.cached_hash() && a == b) return;
+		
+		size_t len = path.size();
+		if (a.is_map()) {
+			map_t const & x = a.map(), & y = b.map();
+			for (auto const & [key, e] : x) {
+				append_key(key);
+				auto i = y.find(key);
+				if (i == y.end()) op("remove");
+				else diff(e, i->second);
+				path.resize(len);
+			}
+			for (auto const & [key, e] : y) {
+				if (x.contains(key)) continue;
+				append_key(key);
+				op("add", &e);
+				path.resize(len);
+			}
+			return;
+		}
+		
+		ary_t const & x = a.array(), & y = b.array();
+		size_t pre = 0, xe = x.size(), ye = y.size();
+		while (pre < xe && pre < ye && same(x[pre], y[pre])) pre++;
+		while (xe > pre && ye > pre && same(x[xe - 1], y[ye - 1])) xe--, ye--;
+		size_t common = std::min(xe, ye) - pre;
+		for (size_t i = pre; i < pre + common; i++) {
+			append_index(i);
+			diff(x[i], y[i]);
+			path.resize(len);
+		}
+		for (size_t i = pre + common; i < xe; i++) {
+			append_index(pre + common);
+			op("remove");
+			path.resize(len);
+		}
+		for (size_t i = pre + common; i < ye; i++) {
+			append_index(i);
+			op("add", &y[i]);
+			path.resize(len);
+		}
+	}
+};
+
+namespace {
+	
+	// the container holding the value a pointer refers to and the last segment, no container for the root itself
+	struct patch_location {
+		aeon * parent;
+		std::string_view key;
+	};
+	
+	struct patcher {
+		aeon & root;
+		std::string text {};
+		
+		[[noreturn]] static void fail(std::string_view msg, std::string_view pointer) {
+			throw aeon::patch_exception { std::string { msg } + ": \"" + std::string { pointer } + "\"" };
+		}
+		
+		static aeon * child(aeon & v, std::string_view key) {
+			if (v.is_map()) {
+				auto i = v.map().find(key);
+				return i == v.map().end() ? nullptr : &i->second;
+			}
+			if (v.is_array()) {
+				size_t index = pointer_index(key);
+				return index < v.array().size() ? &v.array()[index] : nullptr;
+			}
+			return nullptr;
+		}
+		
+		patch_location locate(std::string_view pointer) {
+			text.clear();
+			std::vector<std::pair<size_t, bool>> spans;
+			try {
+				spans = split_pointer(pointer, text);
+			} catch (std::invalid_argument const &) {
+				fail("invalid pointer", pointer);
+			}
+			if (spans.empty()) return { nullptr, {} };
+			
+			aeon * cur = &root;
+			size_t begin = 0;
+			for (size_t i = 0; i < spans.size() - 1; i++) {
+				cur = child(*cur, { text.data() + begin, spans[i].first - begin });
+				if (!cur) fail("path not found", pointer);
+				begin = spans[i].first;
+			}
+			if (!cur->is_map() && !cur->is_array()) fail("path not found", pointer);
+			return { cur, { text.data() + begin, spans.back().first - begin } };
+		}
+		
+		aeon & get(std::string_view pointer) {
+			patch_location loc = locate(pointer);
+			if (!loc.parent) return root;
+			aeon * v = child(*loc.parent, loc.key);
+			if (!v) fail("path not found", pointer);
+			return *v;
+		}
+		
+		void add(std::string_view pointer, aeon && value) {
+			patch_location loc = locate(pointer);
+			if (!loc.parent) {
+				root = std::move(value);
+			} else if (loc.parent->is_map()) {
+				loc.parent->map().insert_or_assign(loc.key, std::move(value));
+			} else {
+				aeon::ary_t & ary = loc.parent->array();
+				size_t index = loc.key == "-" ? ary.size() : pointer_index(loc.key);
+				if (index > ary.size()) fail("index out of range", pointer);
+				ary.insert(ary.begin() + index, std::move(value));
+			}
+		}
+		
+		aeon remove(std::string_view pointer) {
+			patch_location loc = locate(pointer);
+			if (!loc.parent) fail("cannot remove the root", pointer);
+			aeon * v = child(*loc.parent, loc.key);
+			if (!v) fail("path not found", pointer);
+			aeon ret = std::move(*v);
+			if (loc.parent->is_map()) loc.parent->map().erase(loc.key);
+			else loc.parent->array().erase(loc.parent->array().begin() + (v - loc.parent->array().data()));
+			return ret;
+		}
+	};
+	
+	aeon * patch_member(aeon & op, std::string_view key) {
+		auto i = op.map().find(key);
+		return i == op.map().end() ? nullptr : &i->second;
+	}
+}
+
+uint64_t aeon::hash() const {
+	uint64_t h = structural_hash(*this, [](aeon const & e){ return e.hash(); });
+	// a lazy container has been parsed by now
+	if (m_type == type_t::array) m_ary->hash = h;
+	else if (m_type == type_t::map) m_map->hash = h;
+	return h;
+}
+
+uint64_t aeon::cached_hash() const {
+	switch (m_type) {
+		case type_t::array: return m_ary->hash;
+		case type_t::map: return m_map->hash;
+		default: return hash();
+	}
+}
+
+aeon aeon::diff(aeon const & from, aeon const & to) {
+	aeon patch;
+	differ d { patch.array() };
+	(void)from.hash();
+	(void)to.hash();
+	d.diff(from, to);
+	return patch;
+}
+
+void aeon::apply_patch(aeon const & patch) {
+	aeon copy = patch;
+	apply_patch(std::move(copy));
+}
+
+void aeon::apply_patch(aeon && patch) {
+	if (!patch.is_array()) throw patch_exception {"patch must be an array of operations"};
+	
+	patcher p { *this };
+	for (aeon & op : patch.array()) {
+		if (!op.is_map()) throw patch_exception {"patch operation must be a map"};
+		aeon * name = patch_member(op, "op");
+		aeon * path = patch_member(op, "path");
+		if (!name || !name->is_string() || !path || !path->is_string()) throw patch_exception {"patch operation needs an op and a path"};
+		std::string_view pointer = path->string();
+		
+		auto value = [&]() -> aeon & {
+			aeon * v = patch_member(op, "value");
+			if (!v) p.fail("operation needs a value", pointer);
+			return *v;
+		};
+		auto from = [&]() -> std::string_view {
+			aeon * v = patch_member(op, "from");
+			if (!v || !v->is_string()) p.fail("operation needs a from pointer", pointer);
+			return v->string();
+		};
+		
+		std::string_view n = name->string();
+		if (n == "add") {
+			p.add(pointer, std::move(value()));
+		} else if (n == "remove") {
+			p.remove(pointer);
+		} else if (n == "replace") {
+			aeon & v = value();
+			p.get(pointer) = std::move(v);
+		} else if (n == "move") {
+			std::string_view src = from();
+			if (pointer.size() > src.size() && pointer.starts_with(src) && pointer[src.size()] == '/') p.fail("cannot move a value into itself", pointer);
+			p.add(pointer, p.remove(src));
+		} else if (n == "copy") {
+			aeon copy = p.get(from());
+			p.add(pointer, std::move(copy));
+		} else if (n == "test") {
+			aeon & v = value();
+			if (!(p.get(pointer) == v)) p.fail("test failed", pointer);
+		} else {
+			throw patch_exception {"unknown patch operation: \"" + str_t { n } + "\""};
+		}
+	}
+}
+
+void aeon::merge_patch(aeon const & patch) {
+	aeon copy = patch;
+	merge_patch(std::move(copy));
+}
+
+void aeon::merge_patch(aeon && patch) {
+	if (!patch.is_map()) {
+		*this = std::move(patch);
+		return;
+	}
+	map_t & target = map();
+	for (auto & [key, value] : patch.map()) {
+		if (value.is_null()) target.erase(key);
+		else target[key].merge_patch(std::move(value));
+	}
+}
+
+// ----------------
+// DOCUMENT
+// ----------------
+
+aeon::document::document() = default;
+
+void aeon::document::clear() {
+	m_root = aeon {};
+	m_arena.reset();
+}
+
+// ================================================================
+// OPERATORS
+// ================================================================
+
+bool aeon::operator == (aeon const & other) const {
+	if (m_type != other.m_type) return false;
+	switch (m_type) {
+		case type_t::nul: return true;
+		case type_t::boolean: return m_bool == other.m_bool;
+		case type_t::integer: return m_int == other.m_int;
+		case type_t::floating: return m_flt == other.m_flt;
+		case type_t::string: return view() == other.view();
+		case type_t::array:
+			return get<ary_t>() == other.get<ary_t>();
+		case type_t::map:
+			return get<map_t>() == other.get<map_t>();
+	}
+	return false;
+}
+
+// ----------------
+// ARRAY
+// ----------------
+aeon & aeon::operator [] (size_t idx) {
+	auto & ary = array();
+	if (idx >= ary.size()) ary.resize(idx + 1);
+	return ary[idx];
+}
+
+aeon const & aeon::operator [] (size_t idx) const {
+	auto const & ary = array();
+	if (idx >= ary.size()) return null_aeon;
+	return ary[idx];
+}
+
+// ----------------
+// MAP
+// ----------------
+aeon & aeon::operator [] (str_t const & key) {
+	auto & val = map();
+	key_pool * pool = key_pool::current();
+	if (!pool) return val[key];
+	auto i = val.find(key);
+	if (i != val.end()) return i->second;
+	return val[pool->intern(key)];
+}
+
+aeon const & aeon::operator [] (str_t const & key) const {
+	auto const & val = map();
+	auto i = val.find(key);
+	if (i == val.end()) return null_aeon;
+	else return i->second;
+}
+
+aeon & aeon::operator [] (key_t const & key) {
+	return map()[key];
+}
+
+aeon const & aeon::operator [] (key_t const & key) const {
+	auto const & val = map();
+	auto i = val.find(key);
+	if (i == val.end()) return null_aeon;
+	else return i->second;
+}
+
+// ----------------
+// PATH
+// ----------------
+aeon const & aeon::operator [] (path const & p) const {
+	aeon const * v = p.find(*this);
+	return v ? *v : null_aeon;
 }
 
 // ================================================================
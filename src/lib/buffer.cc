@@ -1,52 +1,152 @@
 #include "meadow/buffer.hh"
 
+#include <cerrno>
 #include <cstdlib>
 #include <cstring>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/sendfile.h>
+#endif
 
 using namespace meadow;
 
-buffer::buffer(size_t initial_capacity) :
-	m_data { reinterpret_cast<byte_t *>(std::malloc(initial_capacity)) },
-	m_offs { m_data },
-	m_size { 0 },
-	m_resv { initial_capacity }
+namespace {
+	
+	// The resource of buffers given none, malloc(3) and free(3) behind the memory_resource interface. A contiguous buffer's
+	// only block is grown with realloc(3) through it, which can extend the allocation in place.
+	struct heap_resource final : public std::pmr::memory_resource {
+		
+		static void * reallocate(void * p, size_t bytes) {
+			p = std::realloc(p, bytes);
+			if (!p) throw std::bad_alloc {};
+			return p;
+		}
+		
+	private:
+		void * do_allocate(size_t bytes, size_t) override {
+			void * p = std::malloc(bytes);
+			if (!p) throw std::bad_alloc {};
+			return p;
+		}
+		void do_deallocate(void * p, size_t, size_t) override { std::free(p); }
+		bool do_is_equal(std::pmr::memory_resource const & other) const noexcept override { return this == &other; }
+	};
+	
+	heap_resource heap;
+	
+	// the first block of a contiguous buffer, enough for a few small writes without growing it again
+	constexpr size_t min_capacity = 64;
+}
+
+buffer::buffer(std::pmr::memory_resource * res) : m_resource { res } {}
+
+buffer::buffer(size_t initial_capacity, std::pmr::memory_resource * res) : m_resource { res } {
+	if (initial_capacity) m_head = m_tail = make_block(initial_capacity);
+}
+
+buffer::buffer(void * storage, size_t inline_capacity, std::pmr::memory_resource * res) :
+	m_resource { res },
+	m_inline { new (storage) block { nullptr, reinterpret_cast<byte_t *>(storage) + sizeof(block), 0, 0, inline_capacity } }
 {}
 
-buffer::buffer(const_iterator begin, const_iterator end) :
-	m_data { begin < end ? reinterpret_cast<byte_t *>(std::malloc(end - begin)) : nullptr },
-	m_offs { m_data },
-	m_size { begin < end ? static_cast<size_t>(end - begin) : 0 },
-	m_resv { m_size }
-{
-	if (m_size) std::memcpy(m_data, begin, m_size);
+buffer::buffer(const_iterator begin, const_iterator end) {
+	if (begin < end) write(begin, end - begin);
 }
 
-buffer::buffer(buffer const & other) : 
-	m_data { other.m_size ? reinterpret_cast<byte_t *>(std::malloc(other.m_size)) : nullptr },
-	m_offs { m_data },
-	m_size { other.m_size },
-	m_resv { m_size }
-{
-	if (m_size) std::memcpy(m_data, other.m_offs, m_size);
+buffer::buffer(buffer const & other) : m_block_size { other.m_block_size } {
+	if (!other.m_size) return;
+	m_head = m_tail = make_block(other.m_size);
+	m_head->end = other.peek(m_head->data, other.m_size);
+	m_size = other.m_size;
 }
 
 buffer::buffer(buffer && other) : 
-	m_data { other.m_data },
-	m_offs { other.m_offs },
-	m_size { other.m_size },
-	m_resv { other.m_resv }
+	m_block_size { other.m_block_size },
+	m_resource { other.m_resource }
 {
-	new(&other) buffer;
+	steal(other);
+}
+
+buffer buffer::segmented(size_t block_size, std::pmr::memory_resource * res) {
+	buffer b { res };
+	b.m_block_size = block_size ? block_size : 1;
+	return b;
+}
+
+buffer buffer::map_file(char const * path, mapping_t mapping, access_t access) {
+	int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) throw std::system_error { errno, std::generic_category(), path };
+	struct stat st;
+	if (::fstat(fd, &st)) {
+		int err = errno;
+		::close(fd);
+		throw std::system_error { err, std::generic_category(), path };
+	}
+	buffer buf;
+	size_t size = st.st_size;
+	if (!size) {
+		::close(fd);
+		return buf;
+	}
+	
+	// the header is owned by the buffer before mapping, so that nothing leaks if it can't be allocated
+	block * b;
+	try {
+		b = buf.m_head = buf.m_tail = buf.make_block(0);
+	} catch (...) {
+		::close(fd);
+		throw;
+	}
+	bool writable = mapping == mapping_t::copy_on_write;
+	void * data = ::mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0);
+	int err = errno;
+	::close(fd);
+	if (data == MAP_FAILED) throw std::system_error { err, std::generic_category(), path };
+	
+	static constexpr int advice [] { MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED };
+	::madvise(data, size, advice[static_cast<uint8_t>(access)]);
+	
+	// the remainder of the last page reads as zeros and is as writable as the rest
+	size_t const page = ::sysconf(_SC_PAGESIZE);
+	b->data = static_cast<byte_t *>(data);
+	b->end = size;
+	b->mapped = (size + page - 1) / page * page;
+	b->capacity = writable ? b->mapped : size;
+	b->writable = writable;
+	buf.m_size = size;
+	return buf;
 }
 
 buffer::~buffer() {
-	if (m_data) free(m_data);
+	release(m_head);
+}
+
+void buffer::reset() {
+	release(m_head);
+	m_head = m_tail = nullptr;
+	m_size = 0;
 }
 
 // ================================================================
 // GENERAL
 // ================================================================
 
+size_t buffer::capacity() const {
+	size_t cap = 0;
+	for (block * b = m_head; b; b = b->next) cap += b->capacity;
+	return cap;
+}
+
 std::string buffer::hex(bool lowercase) const {
 	static constexpr uint8_t hmask = 0b11110000;
 	static constexpr uint8_t lmask = 0b00001111;
@@ -54,14 +154,15 @@ std::string buffer::hex(bool lowercase) const {
 	
 	std::string str;
 	str.resize(m_size * 2);
-	for (size_t i = 0; i < m_size; i++) {
-		char ch = m_offs[i];
+	size_t i = 0;
+	for (block * b = m_head; b; b = b->next) for (size_t j = b->begin; j < b->end; j++, i++) {
+		char ch = b->data[j];
 		char vh = (ch & hmask) >> 4;
 		char vl = ch & lmask;
 		str[i*2+0] = static_cast<char>(vh > 9 ? abase + vh : 48 + vh);
 		str[i*2+1] = static_cast<char>(vl > 9 ? abase + vl : 48 + vl);
 	}
-	return str;;
+	return str;
 }
 
 // ================================================================
@@ -69,68 +170,271 @@ std::string buffer::hex(bool lowercase) const {
 // ================================================================
 
 void buffer::clear() {
+	if (!m_head) return;
+	if (!m_head->writable) {
+		reset();
+		return;
+	}
+	release(m_head->next);
+	m_head->next = nullptr;
+	m_head->begin = m_head->end = 0;
+	m_tail = m_head;
 	m_size = 0;
-	m_offs = m_data;
 }
 
 void buffer::reserve(size_t s) {
-	if (m_data && s <= m_resv) return;
+	if (m_block_size) {
+		if (s <= m_size) return;
+		if (m_tail && room(m_tail) >= s - m_size) return;
+		append_block(std::max(m_block_size, s - m_size));
+		return;
+	}
+	if (m_head && s <= m_head->capacity && (m_head->writable || s <= m_size)) return;
 	alloc(s);
 }
 
 void buffer::resize(size_t s) {
-	if (m_data) {
-		if (m_size == s) return;
-		if (!s) { clear(); return; }
-		if (s < m_size) { m_size = s; return; }
-		align();
-		if (s <= m_resv) { m_size = s; return; }
+	if (s == m_size) return;
+	if (!s) { clear(); return; }
+	if (s < m_size) { truncate(s); return; }
+	
+	if (m_block_size) {
+		reserve(s);
+		m_tail->end += s - m_size;
+		m_size = s;
+		return;
 	}
+	
+	block * b = m_head;
+	if (b && !b->writable) {
+		alloc(s);
+	} else if (b && b->begin + s <= b->capacity) {
+		// fits behind the current contents
+	} else if (b && s <= b->capacity) {
+		std::memmove(b->data, b->data + b->begin, m_size);
+		b->begin = 0;
+	} else alloc(s);
+	m_head->end = m_head->begin + s;
 	m_size = s;
-	alloc(s);
 }
 
 void buffer::shrink_to_fit() {
-	if (!m_data) return;
-	alloc(m_size);
+	if (!m_head) return;
+	if (!m_block_size) {
+		if (!m_head->mapped) alloc(m_size); // a mapping is left as it is
+	} else if (!m_size) {
+		release(m_head);
+		m_head = m_tail = nullptr;
+	} else truncate(m_size);
+}
+
+void buffer::linearize() {
+	if (m_head == m_tail) return;
+	block * b = make_block(std::max(m_size, m_block_size));
+	b->end = peek(b->data, m_size);
+	release(m_head);
+	m_head = m_tail = b;
 }
 
 // ----------------
 // PRIVATE
 // ----------------
 
-void buffer::align() {
-	if (m_data == m_offs) return;
-	std::memmove(m_data, m_offs, m_size);
-	m_offs = m_data;
+// inline storage is only ever used as the first block, so it is free whenever the chain is empty
+buffer::block * buffer::make_block(size_t capacity) {
+	if (m_inline && !m_head && capacity <= m_inline->capacity) {
+		m_inline->next = nullptr;
+		m_inline->begin = m_inline->end = 0;
+		return m_inline;
+	}
+	std::pmr::memory_resource * res = m_resource ? m_resource : &heap;
+	block * b = new (res->allocate(sizeof(block) + capacity, alignof(block))) block { nullptr, nullptr, 0, 0, capacity };
+	b->data = reinterpret_cast<byte_t *>(b + 1);
+	return b;
 }
 
+void buffer::free_block(block * b) {
+	if (b == m_inline) return;
+	size_t bytes = sizeof(block) + b->capacity;
+	if (b->mapped) {
+		::munmap(b->data, b->capacity);
+		bytes = sizeof(block);
+	}
+	std::pmr::memory_resource * res = m_resource ? m_resource : &heap;
+	res->deallocate(b, bytes, alignof(block));
+}
+
+void buffer::release(block * b) {
+	while (b) {
+		block * next = b->next;
+		free_block(b);
+		b = next;
+	}
+}
+
+// whether a block of this buffer can be relinked into dest
+bool buffer::movable(block const * b, buffer const & dest) const {
+	return b != m_inline && m_resource == dest.m_resource;
+}
+
+// takes the contents of other, which must use the same resource
+void buffer::steal(buffer & other) {
+	if (other.m_head && other.m_head == other.m_inline) {
+		append(other);
+		other.reset();
+		return;
+	}
+	m_head = other.m_head;
+	m_tail = other.m_tail;
+	m_size = other.m_size;
+	other.m_head = other.m_tail = nullptr;
+	other.m_size = 0;
+}
+
+void buffer::append(buffer const & other) {
+	if (!m_block_size) reserve(m_size + other.m_size);
+	for (block * b = other.m_head; b; b = b->next) write(b->data + b->begin, b->end - b->begin);
+}
+
+// Sets the capacity of a contiguous buffer's block, which must hold the current contents. Inline storage has a fixed
+// capacity and is used for anything that fits.
 void buffer::alloc(size_t s) {
-	if (s == m_resv) return;
 	if (!s) {
-		this->~buffer();
-		new (this) buffer;
+		reset();
+		return;
+	}
+	block * b = m_head;
+	if (b && s == b->capacity && b->writable) return;
+	
+	block * n;
+	if (m_inline && s <= m_inline->capacity) {
+		if (b == m_inline) return;
+		n = m_inline;
+		n->next = nullptr;
+		n->begin = n->end = 0;
+	} else if (b && b->mapped && b->writable && s > b->capacity && remap(b, s)) {
 		return;
+	} else if (b && b != m_inline && !b->mapped && !b->begin && !m_resource) {
+		// realloc only when it moves nothing but the contents, otherwise they are copied once into a fresh block
+		b = reinterpret_cast<block *>(heap_resource::reallocate(b, sizeof(block) + s));
+		b->data = reinterpret_cast<byte_t *>(b + 1);
+		b->capacity = s;
+		m_head = m_tail = b;
+		return;
+	} else n = make_block(s);
+	if (b) {
+		std::memcpy(n->data, b->data + b->begin, m_size);
+		n->end = m_size;
+		free_block(b);
 	}
-	align();
-	m_resv = s;
-	if (m_data)
-		m_offs = m_data = reinterpret_cast<byte_t *>(std::realloc(m_data, s));
-	else
-		m_offs = m_data = reinterpret_cast<byte_t *>(std::malloc(s));
+	m_head = m_tail = n;
 }
 
-void buffer::autoreserve(size_t min) {
-	size_t s = static_cast<size_t>(m_resv * 1.5);
-	alloc(s < min ? min : s);
+// Grows a writable mapping to at least s bytes. Pages past the file's are anonymous memory, so the block becomes two
+// mappings, the file's followed by an anonymous one. Either is extended in place while the address space after it is free,
+// otherwise both are moved to a new range by mremap(2), which moves their pages rather than copying the contents.
+bool buffer::remap(block * b, size_t s) {
+#if defined(__linux__)
+	size_t const page = ::sysconf(_SC_PAGESIZE);
+	size_t const length = (s + page - 1) / page * page;
+	byte_t * tail = b->data + b->mapped;
+	if (b->capacity == b->mapped) {
+		void * ext = ::mmap(tail, length - b->mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+		if (ext == tail) {
+			b->capacity = length;
+			return true;
+		}
+		// kernels predating MAP_FIXED_NOREPLACE take it as a hint
+		if (ext != MAP_FAILED) ::munmap(ext, length - b->mapped);
+	} else if (::mremap(tail, b->capacity - b->mapped, length - b->mapped, 0) != MAP_FAILED) {
+		b->capacity = length;
+		return true;
+	}
+	
+	void * range = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (range == MAP_FAILED) return false;
+	byte_t * dest = static_cast<byte_t *>(range);
+	if (::mremap(b->data, b->mapped, b->mapped, MREMAP_MAYMOVE | MREMAP_FIXED, dest) == MAP_FAILED) {
+		::munmap(range, length);
+		return false;
+	}
+	if (b->capacity > b->mapped) {
+		size_t anon = b->capacity - b->mapped;
+		// the file's pages have already moved, so the anonymous ones are copied into place should they fail to
+		if (::mremap(tail, anon, length - b->mapped, MREMAP_MAYMOVE | MREMAP_FIXED, dest + b->mapped) == MAP_FAILED) {
+			std::memcpy(dest + b->mapped, tail, anon);
+			::munmap(tail, anon);
+		}
+	}
+	b->data = dest;
+	b->capacity = length;
+	return true;
+#else
+	(void)b;
+	(void)s;
+	return false;
+#endif
 }
 
-void buffer::check_reserve(size_t req) {
-	size_t ts = m_size + req;
-	if (ts <= m_resv) {
-		if ((m_offs - m_data) + ts <= m_resv) return;
-		else align();
-	} else autoreserve(ts);
+// Makes room for appending cnt bytes to a contiguous buffer. Space freed by consumption is reclaimed once there is at least as
+// much of it as there are contents left, which keeps the copying proportional to what was consumed. Otherwise the contents
+// move to a larger block, never smaller than min_capacity so that a few small writes only allocate once.
+void buffer::make_room(size_t cnt) {
+	block * b = m_head;
+	if (b && b->writable && b->begin >= m_size && m_size + cnt <= b->capacity) {
+		std::memcpy(b->data, b->data + b->begin, m_size);
+		b->begin = 0;
+		b->end = m_size;
+		return;
+	}
+	// a small buffer's own storage still takes anything that fits it
+	size_t grown = b ? std::max(b->capacity + b->capacity / 2, min_capacity) : m_inline && cnt <= m_inline->capacity ? 0 : min_capacity;
+	alloc(std::max(grown, m_size + cnt));
+}
+
+void buffer::append_block(size_t capacity) {
+	link(make_block(capacity));
+}
+
+// appends a block to the chain, an empty last block is dropped first
+void buffer::link(block * b) {
+	if (m_tail && m_tail->begin == m_tail->end) {
+		block * prev = nullptr;
+		if (m_head != m_tail) for (prev = m_head; prev->next != m_tail; prev = prev->next);
+		free_block(m_tail);
+		m_tail = prev;
+		if (prev) prev->next = nullptr;
+		else m_head = nullptr;
+	}
+	if (m_tail) m_tail->next = b;
+	else m_head = b;
+	m_tail = b;
+}
+
+// shortens the contents to s bytes, releasing the blocks past them
+void buffer::truncate(size_t s) {
+	for (block * b = m_head; b; b = b->next) {
+		size_t len = b->end - b->begin;
+		if (s <= len) {
+			b->end = b->begin + s;
+			release(b->next);
+			b->next = nullptr;
+			m_tail = b;
+			break;
+		}
+		s -= len;
+	}
+	m_size = 0;
+	for (block * b = m_head; b; b = b->next) m_size += b->end - b->begin;
+}
+
+buffer::byte_t & buffer::locate(size_t i) const {
+	block * b = m_head;
+	while (i >= b->end - b->begin) {
+		i -= b->end - b->begin;
+		b = b->next;
+	}
+	return b->data[b->begin + i];
 }
 
 // ================================================================
@@ -138,21 +442,379 @@ void buffer::check_reserve(size_t req) {
 // ================================================================
 
 void buffer::write(byte_t const * src, size_t cnt) {
-	check_reserve(cnt);
-	memcpy(m_offs + m_size, src, cnt);
+	if (!cnt) return;
+	size_t room = m_tail ? buffer::room(m_tail) : 0;
+	if (room < cnt) {
+		if (m_block_size) {
+			if (room) {
+				std::memcpy(m_tail->data + m_tail->end, src, room);
+				m_tail->end += room;
+				m_size += room;
+				src += room;
+				cnt -= room;
+			}
+			append_block(std::max(m_block_size, cnt));
+		} else make_room(cnt);
+	}
+	std::memcpy(m_tail->data + m_tail->end, src, cnt);
+	m_tail->end += cnt;
 	m_size += cnt;
 }
 
+std::span<buffer::byte_t const> buffer::peek() const {
+	if (!m_head) return {};
+	return { m_head->data + m_head->begin, m_head->end - m_head->begin };
+}
+
+size_t buffer::peek(byte_t * dst, size_t cnt) const {
+	size_t copied = 0;
+	for (block * b = m_head; b && copied < cnt; b = b->next) {
+		size_t n = std::min(cnt - copied, b->end - b->begin);
+		std::memcpy(dst + copied, b->data + b->begin, n);
+		copied += n;
+	}
+	return copied;
+}
+
+size_t buffer::read(byte_t * dst, size_t cnt) {
+	return consume(peek(dst, cnt));
+}
+
+size_t buffer::consume(size_t cnt) {
+	cnt = std::min(cnt, m_size);
+	m_size -= cnt;
+	for (size_t left = cnt; left;) {
+		block * b = m_head;
+		size_t len = b->end - b->begin;
+		if (left < len) {
+			b->begin += left;
+			break;
+		}
+		left -= len;
+		b->begin = b->end;
+		if (b->next) {
+			m_head = b->next;
+			free_block(b);
+		}
+	}
+	// emptied blocks are released except for the last, which starts over
+	if (m_head && m_head->begin == m_head->end && m_head->next) {
+		block * b = m_head;
+		m_head = b->next;
+		free_block(b);
+	}
+	if (!m_size && m_head) {
+		if (m_head->writable) m_head->begin = m_head->end = 0;
+		else reset();
+	}
+	return cnt;
+}
+
 size_t buffer::transfer(buffer & dest, size_t cnt) {
-	return 0; // FIXME
+	if (&dest == this) return 0;
+	cnt = std::min(cnt, m_size);
+	if (!cnt) return 0;
+	
+	// everything into an empty buffer able to take all of the blocks as they are
+	if (cnt == m_size && !dest.m_size && (dest.m_block_size || m_head == m_tail) && movable(m_head, dest)) {
+		dest.release(dest.m_head);
+		dest.m_head = m_head;
+		dest.m_tail = m_tail;
+		dest.m_size = m_size;
+		m_head = m_tail = nullptr;
+		m_size = 0;
+		return cnt;
+	}
+	
+	size_t left = cnt;
+	if (dest.m_block_size) while (m_head && m_head->end - m_head->begin <= left) {
+		block * b = m_head;
+		size_t len = b->end - b->begin;
+		if (!len || !movable(b, dest)) break;
+		m_head = b->next;
+		if (!m_head) m_tail = nullptr;
+		b->next = nullptr;
+		dest.link(b);
+		dest.m_size += len;
+		m_size -= len;
+		left -= len;
+	}
+	
+	while (left) {
+		std::span<byte_t const> front = peek();
+		size_t n = std::min(left, front.size());
+		dest.write(front.data(), n);
+		consume(n);
+		left -= n;
+	}
+	return cnt;
+}
+
+// ================================================================
+// DESCRIPTOR IO
+// ================================================================
+
+ssize_t buffer::read_from(int fd, size_t max) {
+	byte_t extra [1 << 16];
+	iovec iov [2];
+	int iovcnt = 0;
+	
+	// a segmented buffer whose last block is full starts a new one up front, which stays as the (empty) last block should
+	// nothing be read, so that the next call reads into it rather than allocating again
+	if (m_block_size && (!m_tail || !room(m_tail))) link(make_block(m_block_size));
+	
+	block * tail = m_tail;
+	size_t room = tail ? std::min(max, buffer::room(tail)) : 0;
+	if (room) iov[iovcnt++] = { tail->data + tail->end, room };
+	if (room < max) iov[iovcnt++] = { extra, std::min(sizeof(extra), max - room) };
+	
+	ssize_t n;
+	do n = ::readv(fd, iov, iovcnt); while (n < 0 && errno == EINTR);
+	if (n <= 0) return n;
+	
+	size_t in_room = std::min<size_t>(n, room);
+	if (in_room) {
+		tail->end += in_room;
+		m_size += in_room;
+	}
+	
+	// anything beyond the free space is appended, in blocks of the usual size if segmented
+	size_t rest = n - in_room;
+	size_t piece = m_block_size ? m_block_size : rest;
+	for (size_t off = 0; off < rest; off += piece) write(extra + off, std::min(piece, rest - off));
+	return n;
+}
+
+ssize_t buffer::write_to(int fd, size_t max) {
+	static constexpr int IOV_COUNT = 64;
+	iovec iov [IOV_COUNT];
+	int iovcnt = 0;
+	size_t total = 0;
+	for (block * b = m_head; b && iovcnt < IOV_COUNT && total < max; b = b->next) {
+		size_t len = std::min(b->end - b->begin, max - total);
+		if (!len) continue;
+		iov[iovcnt++] = { b->data + b->begin, len };
+		total += len;
+	}
+	if (!iovcnt) return 0;
+	
+	ssize_t n;
+	do n = ::writev(fd, iov, iovcnt); while (n < 0 && errno == EINTR);
+	if (n > 0) consume(n);
+	return n;
+}
+
+#if defined(__linux__)
+
+namespace {
+	
+	// kept empty between calls, so that nothing read for one transfer can end up in another
+	struct splice_pipe {
+		int fds [2] = { -1, -1 };
+		size_t capacity = 0;
+		
+		~splice_pipe() { close(); }
+		
+		bool open() {
+			if (fds[0] >= 0) return true;
+			if (::pipe2(fds, O_CLOEXEC)) return false;
+			int cap = ::fcntl(fds[0], F_GETPIPE_SZ);
+			capacity = cap > 0 ? cap : 4096;
+			return true;
+		}
+		
+		void close() {
+			if (fds[0] < 0) return;
+			::close(fds[0]);
+			::close(fds[1]);
+			fds[0] = fds[1] = -1;
+		}
+	};
+}
+
+ssize_t buffer::splice(int in, int out, size_t cnt) {
+	struct stat st;
+	if (!::fstat(in, &st) && S_ISREG(st.st_mode)) {
+		ssize_t n;
+		do n = ::sendfile(out, in, nullptr, cnt); while (n < 0 && errno == EINTR);
+		return n;
+	}
+	
+	static thread_local splice_pipe pipe;
+	if (!pipe.open()) return -1;
+	
+	ssize_t n;
+	do n = ::splice(in, nullptr, pipe.fds[1], nullptr, std::min(cnt, pipe.capacity), SPLICE_F_MOVE); while (n < 0 && errno == EINTR);
+	if (n <= 0) return n;
+	
+	for (size_t left = n; left;) {
+		ssize_t m = ::splice(pipe.fds[0], nullptr, out, nullptr, left, SPLICE_F_MOVE);
+		if (m >= 0) {
+			left -= m;
+			continue;
+		}
+		if (errno == EINTR) continue;
+		if (errno == EAGAIN) {
+			pollfd pfd { out, POLLOUT, 0 };
+			::poll(&pfd, 1, -1);
+			continue;
+		}
+		// the pipe can't be emptied, so it is discarded along with its contents
+		int err = errno;
+		pipe.close();
+		errno = err;
+		return -1;
+	}
+	return n;
+}
+
+#endif
+
+// ================================================================
+// BINARY CODEC
+// ================================================================
+
+void buffer::writer::commit() {
+	if (!m_block) return;
+	size_t n = m_cur - (m_block->data + m_block->end);
+	m_block->end += n;
+	m_buf.m_size += n;
+}
+
+void buffer::writer::refresh() {
+	m_block = m_buf.m_tail;
+	m_cur = m_block ? m_block->data + m_block->end : nullptr;
+	m_end = m_block ? m_cur + room(m_block) : nullptr;
+}
+
+// makes the last block's free space at least cnt bytes, the way write() would
+void buffer::writer::grow(size_t cnt) {
+	commit();
+	if (!m_buf.m_tail || room(m_buf.m_tail) < cnt) {
+		if (m_buf.m_block_size) m_buf.append_block(std::max(m_buf.m_block_size, cnt));
+		else m_buf.make_room(cnt);
+	}
+	refresh();
+}
+
+void buffer::writer::raw_slow(void const * src, size_t cnt) {
+	commit();
+	m_buf.write(static_cast<byte_t const *>(src), cnt);
+	refresh();
+}
+
+void buffer::reader::commit() {
+	m_buf.consume(m_cur - m_start);
+	refresh();
+}
+
+void buffer::reader::refresh() {
+	std::span<byte_t const> front = m_buf.peek();
+	m_start = m_cur = front.data();
+	m_end = m_cur + front.size();
+}
+
+// reads a value spanning blocks, or running past the end
+void buffer::reader::take(void * dst, size_t cnt) {
+	if (cnt > remaining()) throw std::out_of_range { "buffer::reader: not enough contents left" };
+	commit();
+	m_buf.read(static_cast<byte_t *>(dst), cnt);
+	refresh();
+}
+
+void buffer::reader::skip(size_t cnt) {
+	if (cnt > remaining()) throw std::out_of_range { "buffer::reader: not enough contents left" };
+	if (static_cast<size_t>(m_end - m_cur) >= cnt) {
+		m_cur += cnt;
+		return;
+	}
+	commit();
+	m_buf.consume(cnt);
+	refresh();
+}
+
+size_t buffer::reader::length() {
+	uint64_t n = varint();
+	if (n > remaining()) throw std::out_of_range { "buffer::reader: length prefix exceeds the remaining contents" };
+	return n;
+}
+
+std::vector<buffer::byte_t> buffer::reader::bytes() {
+	std::vector<byte_t> v (length());
+	raw(v.data(), v.size());
+	return v;
+}
+
+std::string buffer::reader::string() {
+	std::string v (length(), '\0');
+	raw(v.data(), v.size());
+	return v;
+}
+
+uint64_t buffer::reader::varint_slow() {
+	byte_t tmp [10];
+	byte_t const * p = m_cur;
+	size_t avail = m_end - m_cur;
+	if (avail < sizeof(tmp) && avail < remaining()) {
+		// the rest of the value is in the following blocks
+		commit();
+		avail = m_buf.peek(tmp, sizeof(tmp));
+		p = tmp;
+	}
+	uint64_t v = 0;
+	for (size_t i = 0; i < std::min(avail, sizeof(tmp)); i++) {
+		byte_t b = p[i];
+		if (i == 9 && b > 1) throw std::overflow_error { "buffer::reader: varint exceeds 64 bits" };
+		v |= static_cast<uint64_t>(b & 0x7F) << (7 * i);
+		if (!(b & 0x80)) {
+			if (p == tmp) {
+				m_buf.consume(i + 1);
+				refresh();
+			} else m_cur += i + 1;
+			return v;
+		}
+	}
+	if (avail >= sizeof(tmp)) throw std::overflow_error { "buffer::reader: varint exceeds 64 bits" };
+	throw std::out_of_range { "buffer::reader: not enough contents left" };
 }
 
 // ================================================================
 // OPERATORS
 // ================================================================
 
+buffer & buffer::operator = (buffer const & other) {
+	if (this == &other) return *this;
+	clear();
+	m_block_size = other.m_block_size;
+	append(other);
+	return *this;
+}
+
+buffer & buffer::operator = (buffer && other) {
+	if (this == &other) return *this;
+	reset();
+	m_block_size = other.m_block_size;
+	if (m_resource == other.m_resource) {
+		steal(other);
+	} else {
+		append(other);
+		other.reset();
+	}
+	return *this;
+}
+
 bool buffer::operator == (buffer const & other) const {
-	if (!m_data && !other.m_data) return true;
 	if (m_size != other.m_size) return false;
-	return !std::memcmp(m_offs, other.m_offs, m_size);
+	block const * a = m_head, * b = other.m_head;
+	size_t ai = a ? a->begin : 0, bi = b ? b->begin : 0;
+	for (size_t left = m_size; left;) {
+		while (ai == a->end) { a = a->next; ai = a->begin; }
+		while (bi == b->end) { b = b->next; bi = b->begin; }
+		size_t n = std::min({ left, a->end - ai, b->end - bi });
+		if (std::memcmp(a->data + ai, b->data + bi, n)) return false;
+		ai += n;
+		bi += n;
+		left -= n;
+	}
+	return true;
 }
@@ -1,16 +1,89 @@
 #include "tests.hh"
 
 #include "meadow/aeon.hh"
+#include "meadow/aeon_bind.hh"
+#include "meadow/buffer.hh"
+#include "meadow/time.hh"
 
+#include <fcntl.h>
+#include <malloc.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 using aeon = meadow::aeon;
 
+// ALLOCATION ACCOUNTING -- every global allocation made by the test binary and the library is counted
+static std::atomic_size_t alloc_count {0};
+void * operator new (size_t size) { alloc_count++; if (void * p = std::malloc(size)) return p; throw std::bad_alloc {}; }
+void operator delete (void * p) noexcept { std::free(p); }
+void operator delete (void * p, size_t) noexcept { std::free(p); }
+void * operator new (size_t size, std::align_val_t align) {
+	alloc_count++;
+	if (void * p = std::aligned_alloc(static_cast<size_t>(align), (size + static_cast<size_t>(align) - 1) & ~(static_cast<size_t>(align) - 1))) return p;
+	throw std::bad_alloc {};
+}
+void operator delete (void * p, std::align_val_t) noexcept { std::free(p); }
+void operator delete (void * p, size_t, std::align_val_t) noexcept { std::free(p); }
+
+// SCHEMA BINDING TYPES
+struct bind_inner {
+	double weight = 0;
+	std::vector<std::string> tags;
+};
+MEADOW_AEON_BIND(bind_inner, weight, tags)
+
+struct bind_record {
+	int64_t id = 0;
+	std::string name;
+	bool flag = false;
+	uint8_t small = 0;
+	std::optional<std::string> note;
+	std::vector<bind_inner> inner;
+	std::map<std::string, int> counts;
+	aeon extra;
+};
+MEADOW_AEON_BIND(bind_record, id, name, flag, small, note, inner, counts, extra)
+
+struct bind_renamed {
+	int x = 0;
+	int y = 0;
+};
+template <> struct meadow::binding::descriptor<bind_renamed> {
+	static constexpr auto fields = std::make_tuple(meadow::binding::field { "X", &bind_renamed::x }, meadow::binding::field { "why", &bind_renamed::y });
+};
+
+struct bind_wide {
+	int f00, f01, f02, f03, f04, f05, f06, f07, f08, f09, f10, f11, f12, f13, f14, f15;
+	int f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26, f27, f28, f29, f30, f31;
+};
+MEADOW_AEON_BIND(bind_wide, f00, f01, f02, f03, f04, f05, f06, f07, f08, f09, f10, f11, f12, f13, f14, f15,
+	f16, f17, f18, f19, f20, f21, f22, f23, f24, f25, f26, f27, f28, f29, f30, f31)
+
+struct bind_bench {
+	int64_t id = 0;
+	std::string name;
+	double score = 0;
+	std::vector<std::string> tags;
+	bool flag = false;
+};
+MEADOW_AEON_BIND(bind_bench, id, name, score, tags, flag)
+
 void test_aeon() {
 	
 	TEST(aeon::jsonify_string("TEST") == "\"TEST\"")
 	TEST(aeon::jsonify_string("\t\n\\") == "\"\\t\\n\\\\\"")
 	TEST(aeon::jsonify_string("\x07") == "\"\\u0007\"")
+	TEST(aeon::jsonify_string("\xC3\xA9") == "\"\xC3\xA9\"")
 	
 	aeon test;
 	
@@ -68,6 +141,13 @@ void test_aeon() {
 		TEST(test.deserialize_json("\"test lawl\"") == "test lawl")
 	}
 	
+	{
+		aeon lit ("test lawl");
+		TEST(lit.is_string())
+		TEST(lit == aeon { std::string_view { "test lawl" } })
+		TEST(aeon { "" }.is_string())
+	}
+	
 	{
 		test[0] = 5;
 		test[1] = 2.3;
@@ -101,7 +181,31 @@ void test_aeon() {
 		TEST(aeon::deserialize_json("12.5e+3") == 12500)
 		TEST(aeon::deserialize_json("\"TEST\"") == "TEST")
 		TEST(aeon::deserialize_json("\"\\nwat\\\"\\\\\"") == "\nwat\"\\")
-		//TEST(aeon::deserialize_json("\"<\\u0047>\"") == "<G>") // FIXME
+		TEST(aeon::deserialize_json("\"<\\u0047>\"") == "<G>")
+		TEST(aeon::deserialize_json("\"\\u00e9\\ud83d\\ude00\"") == "\xC3\xA9\xF0\x9F\x98\x80")
+		TEST(aeon::deserialize_json("\"a\\/b\"") == "a/b")
+	}
+	
+	// STRUCTURAL INDEX -- tokens, quotes, and escapes straddling block boundaries
+	{
+		for (size_t pad = 0; pad < 140; pad++) {
+			std::string str (pad, ' ');
+			str += "[\"" + std::string(pad, 'x') + "\\\\\\\"\", 12345, \"{[,:]}\", null]";
+			test = aeon::deserialize_json(str);
+			TEST(test.size() == 4)
+			TEST(test[0] == std::string(pad, 'x') + "\\\"")
+			TEST(test[1] == 12345)
+			TEST(test[2] == "{[,:]}")
+			TEST(test[3] == aeon {})
+		}
+		
+		auto throws = [](std::string_view str) { try { (void)aeon::deserialize_json(str); } catch (aeon::deserialize_exception const &) { return true; } return false; };
+		TEST(throws("nullx"))
+		TEST(throws("[1x]"))
+		TEST(throws("{a\":1}"))
+		TEST(throws("\"unterminated"))
+		TEST(throws("\"ctl\x01\""))
+		TEST(throws("[1, 2"))
 	}
 	
 	{
@@ -128,6 +232,1156 @@ void test_aeon() {
 		TEST(testc == aeon::deserialize_json(testc.serialize_json()))
 	}
 	
+	// DOCUMENTS
+	{
+		aeon::document doc;
+		auto const & root = aeon::deserialize_json("{\"str\":\"lawl\",\"esc\":\"a\\nb\",\"ary\":[1, 2.5, null, [true]],\"map\":{\"k\\\"ey\":\"v\"}}", doc);
+		TEST(&root == &doc.root())
+		TEST(root.size() == 4)
+		TEST(root["str"] == "lawl")
+		TEST(root["str"].string() == "lawl")
+		TEST(root["esc"] == "a\nb")
+		TEST(root["ary"][0] == 1)
+		TEST(root["ary"][1] == 2.5)
+		TEST(root["ary"][2] == aeon {})
+		TEST(root["ary"][3][0] == true)
+		TEST(root["map"]["k\"ey"] == "v")
+		TEST(root == aeon::deserialize_json(root.serialize_json()))
+		
+		aeon copy = root;
+		TEST(copy == root)
+		copy["str"] = "changed";
+		copy["ary"][3][1] = 5;
+		TEST(root["str"] == "lawl")
+		TEST(root["ary"][3].size() == 1)
+		
+		aeon::document moved = std::move(doc);
+		TEST(moved->size() == 4)
+		moved.clear();
+		TEST(moved->is_null())
+		TEST(copy["ary"][3][0] == true)
+		TEST(copy["str"] == "changed")
+		
+		TEST(aeon::deserialize_json("\"top\"", moved) == "top")
+	}
+	
+	// BORROWED PARSING
+	{
+		std::string json = "{\"plain\":\"a long enough string to not fit inline\",\"esc\":\"tab\\there\",\"list\":[\"x\", \"y\"]}";
+		auto within = [&](std::string_view v) { return v.data() >= json.data() && v.data() < json.data() + json.size(); };
+		
+		aeon b = aeon::deserialize_json_borrowed(json);
+		TEST(b == aeon::deserialize_json(json))
+		TEST(within(std::as_const(b)["plain"].string()))
+		TEST(within(std::as_const(b)["list"][1].string()))
+		TEST(!within(std::as_const(b)["esc"].string()))
+		TEST(std::as_const(b)["esc"] == "tab\there")
+		
+		aeon copy = b;
+		TEST(!within(std::as_const(copy)["plain"].string()))
+		b["plain"].string() += "!";
+		TEST(!within(std::as_const(b)["plain"].string()))
+		TEST(std::as_const(b)["plain"] == "a long enough string to not fit inline!")
+		
+		aeon::document doc;
+		auto const & root = aeon::deserialize_json_borrowed(json, doc);
+		TEST(root == copy)
+		TEST(within(root["plain"].string()))
+		TEST(!within(root["esc"].string()))
+	}
+	
+	// STREAMING SERIALIZATION
+	{
+		test = aeon::deserialize_json("{\"a\":[1, 2.5, \"three\", null, true], \"b\":{\"c\":\"\\u0001\"}}");
+		std::string expected = test.serialize_json();
+		
+		meadow::buffer buf;
+		test.serialize_json(buf);
+		TEST(std::string_view(reinterpret_cast<char const *>(buf.data()), buf.size()) == expected)
+		
+		std::string out = "prefix:";
+		test.serialize_json(std::back_inserter(out));
+		TEST(out == "prefix:" + expected)
+		
+		std::FILE * tmp = std::tmpfile();
+		test.serialize_json(fileno(tmp));
+		std::rewind(tmp);
+		std::string read (expected.size() + 1, '\0');
+		read.resize(std::fread(read.data(), 1, read.size(), tmp));
+		std::fclose(tmp);
+		TEST(read == expected)
+		
+		aeon deep;
+		aeon * cur = &deep;
+		for (size_t i = 0; i < 5000; i++) cur = &(*cur)[0];
+		*cur = "bottom";
+		std::string deep_json = deep.serialize_json();
+		TEST(deep_json.size() == 5000 * 2 + 8)
+		TEST(aeon::deserialize_json(deep_json) == deep)
+	}
+	
+	// EVENT PARSING
+	{
+		using ev = aeon::event_t;
+		std::string json = "{\"a\": [1, 2.5, \"t\\twd\"], \"skip\": {\"x\": [[], {\"y\": \"]}\"}]}, \"b\": null, \"c\": false}";
+		
+		aeon::reader r { json };
+		std::vector<ev> events;
+		while (r.next()) {
+			events.push_back(r.event());
+			if (r.event() == ev::key && r.string() == "skip") {
+				TEST(r.next() && r.event() == ev::start_map)
+				TEST(r.depth() == 2)
+				r.skip();
+				TEST(r.event() == ev::end_map)
+				TEST(r.depth() == 1)
+			}
+			if (r.event() == ev::string) {
+				TEST(r.string() == "t\twd")
+				TEST(!r.borrowed())
+			}
+			if (r.event() == ev::key) TEST(r.borrowed())
+		}
+		TEST(r.event() == ev::none)
+		TEST((events == std::vector<ev> {
+			ev::start_map,
+				ev::key, ev::start_array, ev::integer, ev::floating, ev::string, ev::end_array,
+				ev::key,
+				ev::key, ev::null,
+				ev::key, ev::boolean,
+			ev::end_map
+		}))
+		
+		struct counter : aeon::handler {
+			size_t scalars = 0, keys = 0, containers = 0, depth = 0, max_depth = 0;
+			void null() override { scalars++; }
+			void boolean(bool) override { scalars++; }
+			void integer(aeon::int_t) override { scalars++; }
+			void floating(aeon::flt_t) override { scalars++; }
+			void string(std::string_view) override { scalars++; }
+			void key(std::string_view) override { keys++; }
+			void start_array() override { containers++; max_depth = std::max(max_depth, ++depth); }
+			void end_array() override { depth--; }
+			void start_map() override { containers++; max_depth = std::max(max_depth, ++depth); }
+			void end_map() override { depth--; }
+		} c;
+		aeon::deserialize_json(json, c);
+		TEST(c.scalars == 6)
+		TEST(c.keys == 6)
+		TEST(c.containers == 6)
+		TEST(c.depth == 0)
+		TEST(c.max_depth == 4)
+		
+		aeon::reader bad { "[1, }" };
+		TEST(bad.next() && bad.next())
+		bool threw = false;
+		try { bad.next(); } catch (aeon::deserialize_exception const &) { threw = true; }
+		TEST(threw)
+	}
+	
+	// INCREMENTAL PARSING
+	{
+		std::string stream = " {\"a\": [1, \"x\\\"]}\"], \"b\": {}}\n\"str\\\\\" -12.5e3 [true, [null]] 42";
+		std::vector<aeon> expected {
+			aeon::deserialize_json("{\"a\": [1, \"x\\\"]}\"], \"b\": {}}"),
+			aeon::deserialize_json("\"str\\\\\""),
+			aeon::deserialize_json("-12.5e3"),
+			aeon::deserialize_json("[true, [null]]"),
+			aeon::deserialize_json("42"),
+		};
+		
+		auto check = [&](aeon::parser & p){
+			if (p.size() != expected.size()) return false;
+			for (aeon const & v : expected) if (p.pop() != v) return false;
+			return p.empty() && !p.pending();
+		};
+		
+		aeon::parser whole;
+		TEST(whole.feed(stream) == 4)
+		whole.finish();
+		TEST(check(whole))
+		
+		aeon::parser bytewise;
+		for (char c : stream) bytewise.feed(&c, 1);
+		TEST(bytewise.size() == 4)
+		TEST(bytewise.pending() == 2)
+		bytewise.finish();
+		TEST(check(bytewise))
+		
+		bool chunked_ok = true;
+		for (size_t i = 0; i < 100; i++) {
+			aeon::parser chunked;
+			for (size_t pos = 0; pos < stream.size();) {
+				size_t n = std::min(rndnum<size_t>(1, 8), stream.size() - pos);
+				chunked.feed(stream.data() + pos, n);
+				pos += n;
+			}
+			chunked.finish();
+			chunked_ok = chunked_ok && check(chunked);
+		}
+		TEST(chunked_ok)
+		
+		aeon::parser recover;
+		TEST(recover.feed("[1] [2") == 1)
+		bool threw = false;
+		try { recover.feed("}]"); } catch (aeon::deserialize_exception const &) { threw = true; }
+		TEST(threw)
+		TEST(recover.feed(" [3]") == 1)
+		TEST(recover.pop() == aeon::deserialize_json("[1]"))
+		TEST(recover.pop() == aeon::deserialize_json("[3]"))
+		
+		threw = false;
+		recover.feed("{\"a\": ");
+		try { recover.finish(); } catch (aeon::deserialize_exception const &) { threw = true; }
+		TEST(threw)
+		TEST(recover.empty() && !recover.pending())
+		
+		// a failed finish discards the value in progress only
+		threw = false;
+		recover.feed("tru");
+		try { recover.finish(); } catch (aeon::deserialize_exception const &) { threw = true; }
+		TEST(threw && !recover.pending())
+		TEST(recover.feed("1 ") == 1 && recover.pop() == aeon::deserialize_json("1"))
+		
+		threw = false;
+		TEST(recover.feed("[1] [2") == 1)
+		try { recover.finish(); } catch (aeon::deserialize_exception const &) { threw = true; }
+		TEST(threw && recover.size() == 1 && !recover.pending())
+		TEST(recover.feed("[3]") == 1 && recover.size() == 2)
+		
+		// a scalar ended by the first byte of a piece, which also starts the next value
+		aeon::parser adjacent;
+		TEST(adjacent.feed("12") == 0 && adjacent.feed("[3]\"x\"") == 3)
+		TEST(adjacent.pop() == 12 && adjacent.pop() == aeon::deserialize_json("[3]") && adjacent.pop() == "x")
+		TEST(recover.pop() == aeon::deserialize_json("[1]") && recover.pop() == aeon::deserialize_json("[3]"))
+	}
+	
+	// NDJSON
+	{
+		std::string ndjson;
+		for (size_t i = 0; i < 100000; i++)
+			ndjson += "{\"id\": " + std::to_string(i) + ", \"tags\": [\"a\", \"b\"], \"text\": \"line with some padding\"}\n" + (i % 7 ? "" : "  \n");
+		
+		auto in_order = [](std::vector<aeon> const & records){
+			for (size_t i = 0; i < records.size(); i++) if (records[i]["id"] != static_cast<aeon::int_t>(i)) return false;
+			return records.size() == 100000;
+		};
+		
+		TEST(in_order(aeon::deserialize_ndjson(ndjson, 1)))
+		TEST(in_order(aeon::deserialize_ndjson(ndjson, 4)))
+		
+		size_t count = 0;
+		aeon::deserialize_ndjson(ndjson, [&](aeon && v){ count += v["id"] == static_cast<aeon::int_t>(count); }, 3);
+		TEST(count == 100000)
+		
+		std::string bad = ndjson;
+		bad.insert(bad.find("\"id\": 60000,"), "[");
+		count = 0;
+		bool threw = false;
+		try {
+			aeon::deserialize_ndjson(bad, [&](aeon &&){ count++; }, 4);
+		} catch (aeon::deserialize_exception const &) { threw = true; }
+		TEST(threw)
+		TEST(count == 60000)
+		
+		// anything after the value on a line is an error, reported with where the line starts
+		std::string trailing = "{\"a\": 1} {\"b\": 2}\n[1] garbage\n";
+		std::string where;
+		count = 0;
+		try {
+			aeon::deserialize_ndjson(trailing, [&](aeon &&){ count++; }, 1);
+		} catch (aeon::deserialize_exception const & e) { where = e.what(); }
+		TEST(count == 0 && where.ends_with("at byte 0"))
+		trailing.erase(8, 9);
+		try {
+			aeon::deserialize_ndjson(trailing, [&](aeon &&){ count++; }, 1);
+		} catch (aeon::deserialize_exception const & e) { where = e.what(); }
+		TEST(count == 1 && where.ends_with("at byte 9"))
+		
+		char path [] = "/tmp/meadow_ndjson_XXXXXX";
+		int fd = ::mkstemp(path);
+		TEST(fd >= 0)
+		TEST(::write(fd, ndjson.data(), ndjson.size()) == static_cast<ssize_t>(ndjson.size()))
+		::close(fd);
+		TEST(in_order(aeon::deserialize_ndjson_file(path)))
+		::unlink(path);
+		
+		threw = false;
+		try { (void)aeon::deserialize_ndjson_file(path); } catch (std::system_error const &) { threw = true; }
+		TEST(threw)
+		TEST(aeon::deserialize_ndjson("").empty())
+	}
+	
+	// NUMBERS
+	{
+		TEST(aeon { 0.1 }.serialize_json() == "0.1")
+		TEST(aeon { 2.0 }.serialize_json() == "2.0")
+		TEST(aeon { 1e300 }.serialize_json() == "1e+300")
+		TEST(aeon { std::numeric_limits<double>::infinity() }.serialize_json() == "null")
+		TEST(aeon::deserialize_json("2.0").is_floating())
+		TEST(aeon::deserialize_json("-9223372036854775808") == std::numeric_limits<aeon::int_t>::min())
+		TEST(aeon::deserialize_json("18446744073709551616").is_floating())
+		TEST(aeon::deserialize_json("1e400").as_floating() == std::numeric_limits<double>::infinity())
+		
+		bool exact = true;
+		for (size_t i = 0; i < 100000; i++) {
+			uint64_t bits = rndnum<uint64_t>(0, std::numeric_limits<uint64_t>::max());
+			double d;
+			std::memcpy(&d, &bits, sizeof(d));
+			if (!std::isfinite(d)) continue;
+			aeon back = aeon::deserialize_json(aeon { d }.serialize_json());
+			exact = exact && back.is_floating() && std::memcmp(&back.floating(), &d, sizeof(d)) == 0;
+		}
+		TEST(exact)
+		
+		aeon str;
+		str = " +12.5";
+		TEST(str.as_integer() == 12)
+		TEST(str.as_floating() == 12.5)
+		TEST(aeon { 0.1 }.as_string() == "0.1")
+	}
+	
+	// BINARY SERIALIZATION
+	{
+		// RFC 8949 appendix A
+		auto hex = [](std::string_view h){
+			std::string out;
+			for (size_t i = 0; i < h.size(); i += 2) out += static_cast<char>(std::stoi(std::string { h.substr(i, 2) }, nullptr, 16));
+			return out;
+		};
+		TEST(aeon { 0 }.serialize_binary() == hex("00"))
+		TEST(aeon { 23 }.serialize_binary() == hex("17"))
+		TEST(aeon { 24 }.serialize_binary() == hex("1818"))
+		TEST(aeon { 1000 }.serialize_binary() == hex("1903e8"))
+		TEST(aeon { 1000000000000 }.serialize_binary() == hex("1b000000e8d4a51000"))
+		TEST(aeon { -1000 }.serialize_binary() == hex("3903e7"))
+		TEST(aeon { 100000.0 }.serialize_binary() == hex("fa47c35000"))
+		TEST(aeon { 1.1 }.serialize_binary() == hex("fb3ff199999999999a"))
+		TEST(aeon { true }.serialize_binary() == hex("f5"))
+		TEST(aeon {}.serialize_binary() == hex("f6"))
+		TEST(aeon::deserialize_json("[1, [2, 3]]").serialize_binary() == hex("8201820203"))
+		TEST(aeon::deserialize_json("{\"a\": \"\xC3\xBC\"}").serialize_binary() == hex("a1616162c3bc"))
+		
+		TEST(aeon::deserialize_binary(hex("f93e00")) == 1.5)
+		TEST(aeon::deserialize_binary(hex("f90001")) == 5.960464477539063e-8)
+		TEST(aeon::deserialize_binary(hex("f9fc00")) == -std::numeric_limits<double>::infinity())
+		TEST(aeon::deserialize_binary(hex("c11a514b67b0")) == 1363896240)
+		TEST(aeon::deserialize_binary(hex("3bffffffffffffffff")).is_floating())
+		TEST(aeon::deserialize_binary(hex("4401020304")) == "\x01\x02\x03\x04")
+		
+		auto throws = [](std::string_view data){
+			try { (void)aeon::deserialize_binary(data); } catch (aeon::deserialize_exception const &) { return true; }
+			return false;
+		};
+		TEST(throws(hex("9f01ff")))
+		TEST(throws(hex("a10101")))
+		TEST(throws(hex("830102")))
+		TEST(throws(hex("9bffffffffffffffff")))
+		TEST(throws(hex("7901")))
+		TEST(throws(""))
+		
+		test = aeon::deserialize_json("{\"a\": [1, -2, 2.5, 0.1, \"three\", null, true, {}], \"b\": {\"c\": \"\\u0001\", \"d\": []}, \"e\": -9223372036854775808}");
+		std::string bin = test.serialize_binary();
+		TEST(aeon::deserialize_binary(bin) == test)
+		aeon::document doc;
+		TEST(aeon::deserialize_binary(bin, doc) == test)
+		
+		meadow::buffer buf;
+		test.serialize_binary(buf);
+		TEST(std::string_view(reinterpret_cast<char const *>(buf.data()), buf.size()) == bin)
+		std::string out;
+		test.serialize_binary(std::back_inserter(out));
+		TEST(out == bin)
+		
+		for (size_t i = 0; i < 100000; i++) {
+			std::string junk = bin;
+			junk[rndnum<size_t>(0, junk.size() - 1)] = static_cast<char>(rndnum<int>(0, 255));
+			junk.resize(rndnum<size_t>(0, junk.size()));
+			try { (void)aeon::deserialize_binary(junk); } catch (aeon::deserialize_exception const &) {}
+		}
+	}
+	
+	// MAP STORAGE
+	{
+		test = aeon::deserialize_json("{\"zeta\": 1, \"alpha\": 2, \"mid\": 3, \"alpha\": 4}");
+		TEST(test.serialize_json() == "{\"zeta\":1,\"alpha\":4,\"mid\":3}")
+		test["first"] = 5;
+		TEST(test.map().begin()->first == "zeta")
+		TEST((test.map().end() - 1)->first == "first")
+		TEST(test.map().erase("alpha") == 1)
+		TEST(test.serialize_json() == "{\"zeta\":1,\"mid\":3,\"first\":5}")
+		
+		aeon::map_t big;
+		for (size_t i = 0; i < 1000; i++) big[std::to_string(i)] = i;
+		bool found = true;
+		for (size_t i = 0; i < 1000; i++) found = found && big.at(std::to_string(i)) == static_cast<aeon::int_t>(i);
+		TEST(found)
+		TEST(!big.contains("1000"))
+		for (size_t i = 0; i < 1000; i += 2) big.erase(std::to_string(i));
+		TEST(big.size() == 500)
+		TEST(big.begin()->first == "1")
+		TEST(big.contains("999") && !big.contains("998"))
+		
+		// erasing in any order keeps every remaining key reachable through the index
+		aeon::map_t shuffled;
+		std::vector<std::string> keys;
+		for (size_t i = 0; i < 2000; i++) {
+			keys.push_back("k" + std::to_string(i * 7919 % 2003));
+			shuffled[keys.back()] = i;
+		}
+		bool reachable = true;
+		for (size_t n = 0; n < 1990; n++) {
+			size_t pick = rndnum<size_t>(0, keys.size() - 1);
+			reachable = reachable && shuffled.erase(keys[pick]) == 1;
+			keys.erase(keys.begin() + pick);
+			if (n % 97 == 0 || keys.size() < 40) for (size_t k = 0; k < keys.size(); k++) {
+				auto it = shuffled.find(keys[k]);
+				reachable = reachable && it != shuffled.end() && it->first == keys[k] && static_cast<size_t>(it - shuffled.begin()) == k;
+			}
+		}
+		TEST(reachable && shuffled.size() == 10)
+		
+		aeon::map_t copy = big;
+		TEST(copy == big)
+		copy["1"] = 0;
+		TEST(copy != big)
+		
+		aeon::map_t small { {"b", 1}, {"", 2}, {"a", 3} };
+		aeon::map_t reordered { {"a", 3}, {"b", 1}, {"", 2} };
+		TEST(small == reordered)
+		TEST(small[""] == 2)
+		
+		std::string json = "{\"plain key\": 1, \"esc\\tkey\": 2}";
+		aeon b = aeon::deserialize_json_borrowed(json);
+		auto within = [&](std::string_view v){ return v.data() >= json.data() && v.data() < json.data() + json.size(); };
+		TEST(within(b.map().begin()->first))
+		TEST(!within((b.map().begin() + 1)->first))
+		aeon owned = b;
+		TEST(!within(owned.map().begin()->first))
+		TEST(owned == b)
+	}
+	
+	// KEY INTERNING
+	{
+		aeon::key_pool pool;
+		aeon::key_t a = pool.intern("alpha");
+		TEST(pool.intern("alpha").data() == a.data())
+		TEST(pool.intern(std::string { "alp" } + "ha").data() == a.data())
+		TEST(pool.intern("beta").data() != a.data())
+		TEST(pool.size() == 2)
+		
+		aeon v;
+		v[a] = 1;
+		TEST(v["alpha"] == 1)
+		TEST(std::as_const(v)[a] == 1)
+		TEST(v.map().begin()->first.interned())
+		aeon copy = v;
+		TEST(copy.map().begin()->first.data() == a.data())
+		
+		TEST(!aeon::key_pool::current())
+		{
+			aeon::key_pool::scope scope { pool };
+			TEST(aeon::key_pool::current() == &pool)
+			aeon parsed = aeon::deserialize_json("{\"alpha\": {\"beta\": 2, \"gamma\": 3}}");
+			TEST(parsed.map().begin()->first.data() == a.data())
+			TEST(parsed["alpha"].map().begin()->first.interned())
+			TEST(parsed["alpha"]["gamma"] == 3)
+			parsed["delta"] = 4;
+			TEST((parsed.map().end() - 1)->first.interned())
+			
+			aeon::key_pool inner;
+			{
+				aeon::key_pool::scope nested { inner };
+				TEST(aeon::key_pool::current() == &inner)
+			}
+			TEST(aeon::key_pool::current() == &pool)
+			
+			auto records = aeon::deserialize_ndjson("{\"alpha\": 1}\n{\"alpha\": 2}\n", 2);
+			TEST(records[1].map().begin()->first.data() == a.data())
+		}
+		TEST(!aeon::key_pool::current())
+		TEST(pool.size() == 4)
+		TEST(!aeon::deserialize_json("{\"alpha\": 1}").map().begin()->first.interned())
+		
+		aeon::key_pool shared;
+		std::vector<std::vector<char const *>> seen (8);
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < seen.size(); t++) threads.emplace_back([&, t](){
+			for (size_t i = 0; i < 5000; i++) seen[t].push_back(shared.intern(std::to_string((i * 7 + t) % 5000)).data());
+		});
+		for (std::thread & t : threads) t.join();
+		bool consistent = true;
+		for (size_t t = 0; t < seen.size(); t++) for (size_t i = 0; i < 5000; i++)
+			consistent = consistent && seen[t][i] == shared.intern(std::to_string((i * 7 + t) % 5000)).data();
+		TEST(consistent)
+		TEST(shared.size() == 5000)
+	}
+	
+	// SCHEMA BINDING
+	{
+		namespace binding = meadow::binding;
+		
+		auto r = binding::deserialize_json<bind_record>(R"({"id": 7, "name": "seven", "unknown": {"a": [1, {"b": 2}]}, "flag": true,
+			"small": 200, "note": null, "inner": [{"weight": 1, "tags": ["a", "b"]}, {"weight": 2.5, "tags": []}],
+			"counts": {"x": 1, "y": 2}, "extra": {"free": ["form", null, 1.5]}})");
+		TEST(r.id == 7)
+		TEST(r.name == "seven")
+		TEST(r.flag)
+		TEST(r.small == 200)
+		TEST(!r.note)
+		TEST(r.inner.size() == 2)
+		TEST(r.inner[0].weight == 1.0 && r.inner[0].tags.size() == 2 && r.inner[0].tags[1] == "b")
+		TEST(r.inner[1].weight == 2.5 && r.inner[1].tags.empty())
+		TEST(r.counts.size() == 2 && r.counts["y"] == 2)
+		TEST(r.extra["free"][2] == 1.5)
+		
+		std::string out = binding::serialize_json(r);
+		TEST(out == R"({"id":7,"name":"seven","flag":true,"small":200,"inner":[{"weight":1.0,"tags":["a","b"]},{"weight":2.5,"tags":[]}],)"
+			R"("counts":{"x":1,"y":2},"extra":{"free":["form",null,1.5]}})")
+		r.note = "a \"quoted\" note";
+		auto round = binding::deserialize_json<bind_record>(binding::serialize_json(r));
+		TEST(round.note && *round.note == r.note)
+		TEST(round.inner[1].weight == 2.5)
+		TEST(aeon::deserialize_json(binding::serialize_json(r)) == aeon::deserialize_json(out.substr(0, out.size() - 1) + ",\"note\":\"a \\\"quoted\\\" note\"}"))
+		
+		bind_renamed p { 1, 2 };
+		binding::deserialize_json(R"({"why": 5, "y": 9, "x": 9})", p);
+		TEST(p.x == 1 && p.y == 5)
+		TEST(binding::serialize_json(p) == R"({"X":1,"why":5})")
+		
+		std::string wide = "{";
+		for (int i = 0; i < 32; i++) wide += meadow::strf("%s\"f%02i\": %i", i ? "," : "", i, i * 3);
+		wide += "}";
+		auto w = binding::deserialize_json<bind_wide>(wide);
+		TEST(w.f00 == 0 && w.f07 == 21 && w.f16 == 48 && w.f31 == 93)
+		TEST(aeon::deserialize_json(binding::serialize_json(w)) == aeon::deserialize_json(wide))
+		
+		TEST(binding::deserialize_json<std::vector<int>>("[1, 2, 3]").size() == 3)
+		TEST(binding::deserialize_json<std::optional<double>>("null") == std::nullopt)
+		TEST(binding::serialize_json(std::vector<std::optional<int>> { 1, std::nullopt }) == "[1,null]")
+		
+		bool threw = false;
+		try { (void)binding::deserialize_json<bind_record>(R"({"id": "seven"})"); } catch (aeon::deserialize_exception const &) { threw = true; }
+		TEST(threw)
+		threw = false;
+		try { (void)binding::deserialize_json<bind_record>(R"({"small": 256})"); } catch (aeon::deserialize_exception const &) { threw = true; }
+		TEST(threw)
+		threw = false;
+		try { (void)binding::deserialize_json<bind_record>(R"({"id": 1.5})"); } catch (aeon::deserialize_exception const &) { threw = true; }
+		TEST(threw)
+		threw = false;
+		try { (void)binding::deserialize_json<bind_record>(R"({"inner": [{"weight": 1}, )"); } catch (aeon::deserialize_exception const &) { threw = true; }
+		TEST(threw)
+		
+		std::string streamed;
+		{
+			aeon::emitter e { streamed };
+			e.start_array();
+			e.integer(1);
+			e.start_map();
+			e.key("k");
+			e.value(aeon::deserialize_json("[true, null]"));
+			e.key("s");
+			e.string("\n");
+			e.end_map();
+			e.floating(0.5);
+			e.end_array();
+		}
+		TEST(streamed == R"([1,{"k":[true,null],"s":"\n"},0.5])")
+	}
+	
+	// PATHS
+	{
+		aeon const rfc = aeon::deserialize_json(R"({"foo": ["bar", "baz"], "": 0, "a/b": 1, "c%d": 2, "e^f": 3, "g|h": 4,
+			"i\\j": 5, "k\"l": 6, " ": 7, "m~n": 8, "*": 9})");
+		TEST(aeon::path("").find(rfc) == &rfc)
+		TEST(rfc[aeon::path("/foo")].size() == 2)
+		TEST(rfc[aeon::path("/foo/0")] == "bar")
+		TEST(rfc[aeon::path("/")] == 0)
+		TEST(rfc[aeon::path("/a~1b")] == 1)
+		TEST(rfc[aeon::path("/c%d")] == 2)
+		TEST(rfc[aeon::path("/i\\j")] == 5)
+		TEST(rfc[aeon::path("/k\"l")] == 6)
+		TEST(rfc[aeon::path("/ ")] == 7)
+		TEST(rfc[aeon::path("/m~0n")] == 8)
+		TEST(rfc[aeon::path("/~2")] == 9)
+		TEST(!aeon::path("/foo/2").find(rfc))
+		TEST(!aeon::path("/foo/01").find(rfc))
+		TEST(!aeon::path("/foo/-").find(rfc))
+		TEST(!aeon::path("/foo/0/deeper").find(rfc))
+		TEST(!aeon::path("/missing/0").find(rfc))
+		TEST(rfc[aeon::path("/missing")].is_null())
+		TEST(rfc.size() == 11)
+		
+		bool threw = false;
+		try { aeon::path p { "foo" }; } catch (std::invalid_argument const &) { threw = true; }
+		TEST(threw)
+		threw = false;
+		try { aeon::path p { "/a~3" }; } catch (std::invalid_argument const &) { threw = true; }
+		TEST(threw)
+		
+		aeon const doc = aeon::deserialize_json(R"({"a": [{"b": 1}, {"c": 2}, {"b": 3}], "d": {"x": {"b": 4}, "y": {"b": 5}}})");
+		aeon::path any_b { "/a/*/b" };
+		TEST(any_b.wildcard() && any_b.size() == 3)
+		std::vector<aeon::int_t> found;
+		any_b.for_each(doc, [&](aeon const & v){ found.push_back(v.integer()); });
+		TEST(found == (std::vector<aeon::int_t> { 1, 3 }))
+		TEST(doc[aeon::path("/*/y/b")] == 5)
+		found.clear();
+		aeon::path("/d/*/b").for_each(doc, [&](aeon const & v){ found.push_back(v.integer()); });
+		TEST(found == (std::vector<aeon::int_t> { 4, 5 }))
+		
+		aeon::path copied = any_b;
+		{ aeon::path temp { "/a/*/b" }; copied = temp; }
+		TEST(copied.find(doc) && *copied.find(doc) == 1)
+		
+		std::vector<aeon> docs;
+		for (int i = 0; i < 5; i++) docs.push_back(aeon::deserialize_json(meadow::strf(R"({"k": {"v": [%i, %i]}})", i, i * 10)));
+		docs.push_back(aeon::deserialize_json("[1, 2]"));
+		std::vector<aeon const *> results (docs.size());
+		aeon::path("/k/v/1").find(docs.data(), docs.size(), results.data());
+		TEST(*results[0] == 0 && *results[4] == 40 && !results[5])
+		
+		std::string json = R"({"skip": {"deep": [1, 2, {"x": "y"}]}, "items": [{"id": 1, "tags": ["a"]}, {"id": 2}, 3], "after": {"id": 9}})";
+		std::vector<aeon> selected;
+		aeon::path("/items/1").select_json(json, [&](aeon && v){ selected.push_back(std::move(v)); });
+		TEST(selected.size() == 1 && selected[0] == aeon::deserialize_json(R"({"id": 2})"))
+		selected.clear();
+		aeon::path("/items/*/id").select_json(json, [&](aeon && v){ selected.push_back(std::move(v)); });
+		TEST(selected.size() == 2 && selected[0] == 1 && selected[1] == 2)
+		selected.clear();
+		aeon::path("/*/id").select_json(json, [&](aeon && v){ selected.push_back(std::move(v)); });
+		TEST(selected.size() == 1 && selected[0] == 9)
+		selected.clear();
+		aeon::path("").select_json(json, [&](aeon && v){ selected.push_back(std::move(v)); });
+		TEST(selected.size() == 1 && selected[0] == aeon::deserialize_json(json))
+		selected.clear();
+		aeon::path("/items/0").select_json(R"({"items": [{"tags": ["a", {"b": null}]}, ]])", [&](aeon && v){ selected.push_back(std::move(v)); });
+		TEST(selected.size() == 1 && selected[0][aeon::path("/tags/1/b")].is_null())
+		threw = false;
+		try { aeon::path("/x/1").select_json(R"({"a": 1, "x": [1, }, 2]})", [](aeon &&){}); } catch (aeon::deserialize_exception const &) { threw = true; }
+		TEST(threw)
+	}
+	
+	// LAZY PARSING
+	{
+		std::string json = R"({"a": {"b": [1, 2, {"c": "d"}]}, "big": [ 1 ,  2 ], "s": "x\ny", "n": 5, "e": {}})";
+		aeon lazy = aeon::deserialize_json_lazy(json);
+		TEST(!lazy.is_lazy())
+		TEST(lazy.map().at("a").is_lazy() && lazy.map().at("big").is_lazy() && lazy.map().at("e").is_lazy())
+		TEST(lazy.map().at("a").is_map() && lazy.map().at("big").is_array())
+		TEST(lazy.map().at("s") == "x\ny" && lazy.map().at("n") == 5)
+		TEST(lazy.serialize_json() == R"({"a":{"b": [1, 2, {"c": "d"}]},"big":[ 1 ,  2 ],"s":"x\ny","n":5,"e":{}})")
+		
+		aeon copy = lazy;
+		TEST(copy.map().at("a").is_lazy())
+		
+		aeon const & clazy = lazy;
+		TEST(clazy["a"]["b"][2]["c"] == "d")
+		TEST(!lazy.map().at("a").is_lazy() && lazy.map().at("big").is_lazy())
+		TEST(lazy[aeon::path("/a/b/1")] == 2)
+		TEST(lazy.serialize_json() == R"({"a":{"b":[1,2,{"c":"d"}]},"big":[ 1 ,  2 ],"s":"x\ny","n":5,"e":{}})")
+		
+		lazy["big"].array().push_back(3);
+		TEST(lazy["big"].size() == 3 && !lazy.map().at("big").is_lazy())
+		TEST(copy == aeon::deserialize_json(json))
+		TEST(!copy.map().at("big").is_lazy())
+		TEST(aeon::deserialize_json_lazy(json).serialize_binary() == aeon::deserialize_json(json).serialize_binary())
+		
+		aeon deferred = aeon::deserialize_json_lazy(R"({"ok": [1], "bad": {"x": [1, tru]}})");
+		TEST(deferred["ok"][0] == 1)
+		bool threw = false;
+		try { (void)deferred["bad"]["x"].size(); } catch (aeon::deserialize_exception const &) { threw = true; }
+		TEST(threw)
+		threw = false;
+		try { (void)aeon::deserialize_json_lazy(R"({"a": [1, 2})"); } catch (aeon::deserialize_exception const &) { threw = true; }
+		TEST(threw)
+		TEST(aeon::deserialize_json_lazy("[[1], 2]")[0].is_lazy())
+		TEST(aeon::deserialize_json_lazy("7") == 7)
+		
+		// the index of the input outlives the tree it was made for as long as a lazy copy refers to it
+		std::string nested;
+		for (int i = 0; i < 200; i++) nested += R"({"pad": "[{\"]", "next": [)";
+		nested += "true";
+		for (int i = 0; i < 200; i++) nested += "]}";
+		aeon outer = aeon::deserialize_json_lazy(nested);
+		aeon inner = outer["next"][0];
+		TEST(inner.is_lazy())
+		outer = aeon {};
+		aeon const * at = &inner;
+		for (int i = 1; i < 199; i++) at = &(*at)["next"][0];
+		TEST((*at)["next"][0] == true && (*at)["pad"] == "[{\"]")
+		TEST(inner == aeon::deserialize_json(nested)["next"][0])
+	}
+	
+	// DIFF AND PATCH
+	{
+		auto patched = [](char const * doc, char const * patch) {
+			aeon v = aeon::deserialize_json(doc);
+			v.apply_patch(aeon::deserialize_json(patch));
+			return v;
+		};
+		auto patch_fails = [](char const * doc, char const * patch) {
+			aeon v = aeon::deserialize_json(doc);
+			try { v.apply_patch(aeon::deserialize_json(patch)); } catch (aeon::patch_exception const &) { return true; }
+			return false;
+		};
+		
+		// RFC 6902 appendix A
+		TEST(patched(R"({"foo": "bar"})", R"([{"op": "add", "path": "/baz", "value": "qux"}])") == aeon::deserialize_json(R"({"baz": "qux", "foo": "bar"})"))
+		TEST(patched(R"({"foo": ["bar", "baz"]})", R"([{"op": "add", "path": "/foo/1", "value": "qux"}])") == aeon::deserialize_json(R"({"foo": ["bar", "qux", "baz"]})"))
+		TEST(patched(R"({"baz": "qux", "foo": "bar"})", R"([{"op": "remove", "path": "/baz"}])") == aeon::deserialize_json(R"({"foo": "bar"})"))
+		TEST(patched(R"({"foo": ["bar", "qux", "baz"]})", R"([{"op": "remove", "path": "/foo/1"}])") == aeon::deserialize_json(R"({"foo": ["bar", "baz"]})"))
+		TEST(patched(R"({"baz": "qux", "foo": "bar"})", R"([{"op": "replace", "path": "/baz", "value": "boo"}])") == aeon::deserialize_json(R"({"baz": "boo", "foo": "bar"})"))
+		TEST(patched(R"({"foo": {"bar": "baz", "waldo": "fred"}, "qux": {"corge": "grault"}})", R"([{"op": "move", "from": "/foo/waldo", "path": "/qux/thud"}])")
+			== aeon::deserialize_json(R"({"foo": {"bar": "baz"}, "qux": {"corge": "grault", "thud": "fred"}})"))
+		TEST(patched(R"({"foo": ["all", "grass", "cows", "eat"]})", R"([{"op": "move", "from": "/foo/1", "path": "/foo/3"}])") == aeon::deserialize_json(R"({"foo": ["all", "cows", "eat", "grass"]})"))
+		TEST(patched(R"({"baz": "qux", "foo": ["a", 2, "c"]})", R"([{"op": "test", "path": "/baz", "value": "qux"}, {"op": "test", "path": "/foo/1", "value": 2}])")
+			== aeon::deserialize_json(R"({"baz": "qux", "foo": ["a", 2, "c"]})"))
+		TEST(patch_fails(R"({"baz": "qux"})", R"([{"op": "test", "path": "/baz", "value": "bar"}])"))
+		TEST(patched(R"({"foo": "bar"})", R"([{"op": "add", "path": "/child", "value": {"grandchild": {}}}])") == aeon::deserialize_json(R"({"foo": "bar", "child": {"grandchild": {}}})"))
+		TEST(patch_fails(R"({"foo": "bar"})", R"([{"op": "add", "path": "/baz/bat", "value": "qux"}])"))
+		TEST(patched(R"({"/": 9, "~1": 10})", R"([{"op": "test", "path": "/~01", "value": 10}])") == aeon::deserialize_json(R"({"/": 9, "~1": 10})"))
+		TEST(patched(R"({"foo": ["bar"]})", R"([{"op": "add", "path": "/foo/-", "value": ["abc", "def"]}])") == aeon::deserialize_json(R"({"foo": ["bar", ["abc", "def"]]})"))
+		TEST(patched(R"({"foo": 1})", R"([{"op": "copy", "from": "/foo", "path": "/bar"}, {"op": "replace", "path": "", "value": [1]}])") == aeon::deserialize_json("[1]"))
+		TEST(patch_fails(R"({"foo": {"a": 1}})", R"([{"op": "move", "from": "/foo", "path": "/foo/a"}])"))
+		TEST(patch_fails(R"({"foo": [1]})", R"([{"op": "add", "path": "/foo/2", "value": 1}])"))
+		TEST(patch_fails(R"({"foo": [1]})", R"([{"op": "remove", "path": "/foo/01"}])"))
+		TEST(patch_fails(R"({"foo": 1})", R"([{"op": "frobnicate", "path": "/foo"}])"))
+		TEST(patch_fails(R"({"foo": 1})", R"([{"op": "replace", "path": "/bar", "value": 1}])"))
+		
+		aeon target = aeon::deserialize_json(R"({"a": []})");
+		aeon patch = aeon::deserialize_json(R"([{"op": "add", "path": "/a/0", "value": "a fairly long string that is moved"}])");
+		target.apply_patch(std::move(patch));
+		TEST(target["a"][0] == "a fairly long string that is moved")
+		TEST(patch[0]["value"].is_null())
+		
+		// RFC 7386 appendix A
+		auto merged = [](char const * doc, char const * patch) {
+			aeon v = aeon::deserialize_json(doc);
+			v.merge_patch(aeon::deserialize_json(patch));
+			return v.serialize_json();
+		};
+		TEST(merged(R"({"a":"b"})", R"({"a":"c"})") == R"({"a":"c"})")
+		TEST(merged(R"({"a":"b"})", R"({"b":"c"})") == R"({"a":"b","b":"c"})")
+		TEST(merged(R"({"a":"b"})", R"({"a":null})") == R"({})")
+		TEST(merged(R"({"a":"b","b":"c"})", R"({"a":null})") == R"({"b":"c"})")
+		TEST(merged(R"({"a":["b"]})", R"({"a":"c"})") == R"({"a":"c"})")
+		TEST(merged(R"({"a":"c"})", R"({"a":["b"]})") == R"({"a":["b"]})")
+		TEST(merged(R"({"a":{"b":"c"}})", R"({"a":{"b":"d","c":null}})") == R"({"a":{"b":"d"}})")
+		TEST(merged(R"({"a":[{"b":"c"}]})", R"({"a":[1]})") == R"({"a":[1]})")
+		TEST(merged(R"(["a","b"])", R"(["c","d"])") == R"(["c","d"])")
+		TEST(merged(R"({"a":"b"})", R"(["c"])") == R"(["c"])")
+		TEST(merged(R"({"a":"foo"})", R"(null)") == R"(null)")
+		TEST(merged(R"({"e":null})", R"({"a":1})") == R"({"e":null,"a":1})")
+		TEST(merged(R"([1,2])", R"({"a":"b","c":null})") == R"({"a":"b"})")
+		TEST(merged(R"({})", R"({"a":{"bb":{"ccc":null}}})") == R"({"a":{"bb":{}}})")
+		
+		TEST(aeon::deserialize_json(R"({"a": 1, "b": [2, 3]})").hash() == aeon::deserialize_json(R"({"b": [2, 3], "a": 1})").hash())
+		TEST(aeon::deserialize_json("[2, 3]").hash() != aeon::deserialize_json("[3, 2]").hash())
+		TEST(aeon::deserialize_json(R"({"a": 1, "b": 2})").hash() != aeon::deserialize_json(R"({"a": 2, "b": 1})").hash())
+		TEST(aeon { 0.0 }.hash() == aeon { -0.0 }.hash())
+		TEST(aeon { 1 }.hash() != aeon { 1.0 }.hash())
+		TEST(aeon { std::string_view { "1" } }.hash() != aeon { 1 }.hash())
+		
+		aeon from = aeon::deserialize_json(R"({"keep": {"deep": [1, 2, 3]}, "change": 1, "gone": true, "list": [1, 2, 3, 4, 5], "a/b~": 0})");
+		aeon to = aeon::deserialize_json(R"({"keep": {"deep": [1, 2, 3]}, "change": "one", "list": [1, 9, 2, 3, 5], "a/b~": 1, "new": null})");
+		aeon d = aeon::diff(from, to);
+		TEST(d == aeon::deserialize_json(R"([{"op": "replace", "path": "/change", "value": "one"}, {"op": "remove", "path": "/gone"},
+			{"op": "replace", "path": "/list/1", "value": 9}, {"op": "replace", "path": "/list/2", "value": 2}, {"op": "replace", "path": "/list/3", "value": 3},
+			{"op": "replace", "path": "/a~1b~0", "value": 1}, {"op": "add", "path": "/new", "value": null}])"))
+		from.apply_patch(d);
+		TEST(from == to)
+		TEST(aeon::diff(to, to).array().empty())
+		
+		// equal hashes are not taken for equal values: the integer here is chosen so that both maps hash the same
+		{
+			auto mix = [](uint64_t h) {
+				h ^= h >> 30;
+				h *= 0xBF58476D1CE4E5B9;
+				h ^= h >> 27;
+				h *= 0x94D049BB133111EB;
+				return h ^ (h >> 31);
+			};
+			auto unmix = [](uint64_t h) {
+				h ^= h >> 31 ^ h >> 62;
+				h *= 0x319642B2D24D8EC3;
+				h ^= h >> 27 ^ h >> 54;
+				h *= 0x96DE1B173F119089;
+				return h ^ h >> 30 ^ h >> 60;
+			};
+			auto key = [](std::string_view k) { return std::hash<std::string_view> {} (k); };
+			uint64_t leaf = mix(mix(mix(4) ^ 0));
+			int64_t crafted = static_cast<int64_t>(unmix(unmix(key("a") ^ key("b") ^ leaf)) ^ mix(4));
+			aeon a = aeon::deserialize_json(R"({"a": 0})");
+			aeon b = aeon::deserialize_json(R"({"b": 0})");
+			b["b"] = crafted;
+			TEST(mix(unmix(12345)) == 12345)
+			TEST(a.hash() == b.hash() && a != b)
+			aeon patch = aeon::diff(a, b);
+			TEST(!patch.array().empty())
+			a.apply_patch(patch);
+			TEST(a == b)
+			aeon wrapped_a = aeon::deserialize_json(R"([{"a": 0}])"), wrapped_b = aeon::deserialize_json("[]");
+			wrapped_b.array().push_back(b);
+			TEST(!aeon::diff(wrapped_a, wrapped_b).array().empty())
+		}
+		
+		// random trees, randomly mutated, always patch back to the mutated tree
+		std::function<aeon(int)> random_tree = [&](int depth) -> aeon {
+			switch (rndnum<int>(0, depth > 0 ? 5 : 3)) {
+				case 0: return aeon {};
+				case 1: return aeon { rndnum<int>(0, 3) };
+				case 2: return aeon { rndnum<int>(0, 1) == 1 };
+				case 3: return aeon { std::string(1, static_cast<char>('a' + rndnum<int>(0, 2))) };
+				case 4: {
+					aeon v;
+					v.array();
+					for (int i = rndnum<int>(0, 5); i > 0; i--) v.array().push_back(random_tree(depth - 1));
+					return v;
+				}
+				default: {
+					aeon v;
+					v.map();
+					for (int i = rndnum<int>(0, 5); i > 0; i--) v.map().insert_or_assign(std::string(1, static_cast<char>('a' + rndnum<int>(0, 6))), random_tree(depth - 1));
+					return v;
+				}
+			}
+		};
+		std::function<void(aeon &, int)> mutate = [&](aeon & v, int depth) {
+			if (v.is_array() && !v.array().empty() && rndnum<int>(0, 3)) {
+				auto & ary = v.array();
+				switch (rndnum<int>(0, 3)) {
+					case 0: ary.erase(ary.begin() + rndnum<size_t>(0, ary.size() - 1)); break;
+					case 1: ary.insert(ary.begin() + rndnum<size_t>(0, ary.size()), random_tree(depth)); break;
+					default: mutate(ary[rndnum<size_t>(0, ary.size() - 1)], depth - 1);
+				}
+			} else if (v.is_map() && !v.map().empty() && rndnum<int>(0, 3)) {
+				auto & map = v.map();
+				switch (rndnum<int>(0, 3)) {
+					case 0: map.erase(map.begin() + rndnum<size_t>(0, map.size() - 1)); break;
+					case 1: map.insert_or_assign(std::string(1, static_cast<char>('a' + rndnum<int>(0, 6))), random_tree(depth)); break;
+					default: mutate((map.begin() + rndnum<size_t>(0, map.size() - 1))->second, depth - 1);
+				}
+			} else {
+				v = random_tree(depth);
+			}
+		};
+		bool round_trips = true;
+		for (int i = 0; i < 2000 && round_trips; i++) {
+			aeon a = random_tree(4);
+			aeon b = a;
+			for (int m = rndnum<int>(1, 4); m > 0; m--) mutate(b, 4);
+			aeon c = a;
+			c.apply_patch(aeon::diff(a, b));
+			round_trips = c == b;
+			aeon e = a;
+			e.apply_patch(aeon::deserialize_json(aeon::diff(a, b).serialize_json()));
+			round_trips = round_trips && e == b;
+		}
+		TEST(round_trips)
+	}
+	
+	// STRUCTURAL HASHING
+	{
+		aeon v = aeon::deserialize_json(R"({"a": {"b": [1, 2, {"c": 3}]}, "d": "e"})");
+		uint64_t h = v.hash();
+		TEST(v.hash() == h)
+		v["a"]["b"][2]["c"] = 4;
+		TEST(v.hash() != h)
+		v["a"]["b"][2]["c"] = 3;
+		TEST(v.hash() == h)
+		v["a"]["b"].array().push_back(aeon {});
+		TEST(v.hash() != h)
+		v["a"]["b"].array().pop_back();
+		TEST(v.hash() == h)
+		
+		aeon copy = v;
+		TEST(copy.hash() == h && copy == v)
+		copy["d"] = std::string { "f" };
+		TEST(copy.hash() != h && !(copy == v))
+		aeon moved = std::move(copy);
+		TEST(moved.hash() != h && moved["d"] == "f")
+		
+		aeon::document doc;
+		aeon::deserialize_json(R"({"d": "e", "a": {"b": [1, 2, {"c": 3}]}})", doc);
+		TEST(doc->hash() == h && *doc == v)
+		TEST(aeon::deserialize_json_lazy(R"({"d": "e", "a": {"b": [1, 2, {"c": 3}]}})").hash() == h)
+		TEST(aeon::deserialize_binary(v.serialize_binary()).hash() == h)
+		
+		std::unordered_set<aeon> unique;
+		for (int i = 0; i < 100; i++) {
+			unique.insert(aeon::deserialize_json(meadow::strf(R"({"id": %i, "tags": ["x", "y"]})", i % 10)));
+			unique.insert(aeon::deserialize_json(meadow::strf(R"({"tags": ["x", "y"], "id": %i})", i % 10)));
+		}
+		TEST(unique.size() == 10)
+		TEST(unique.contains(aeon::deserialize_json(R"({"tags": ["x", "y"], "id": 3})")))
+		
+		// changes made through a held reference to an element are seen by the containers above it
+		aeon c = aeon::deserialize_json("[[1]]"), d = aeon::deserialize_json("[[2]]");
+		aeon & inner = c[0];
+		(void)c.hash();
+		(void)d.hash();
+		inner[0] = 2;
+		TEST(c == d && c.hash() == d.hash())
+		TEST(!aeon::diff(c, d).size())
+		std::unordered_set<aeon> held;
+		held.insert(c);
+		inner[0] = 3;
+		TEST(!held.contains(c))
+		inner[0] = 2;
+		TEST(held.contains(c) && held.contains(d))
+		TEST(!unique.contains(aeon::deserialize_json(R"({"tags": ["y", "x"], "id": 3})")))
+		std::unordered_map<aeon, int> counts;
+		counts[aeon::deserialize_json("[1, 2]")]++;
+		counts[aeon::deserialize_json("[1, 2]")]++;
+		TEST(counts.size() == 1 && counts.begin()->second == 2)
+	}
+	
+	// FROZEN DOCUMENTS
+	{
+		aeon v = aeon::deserialize_json(R"({"zeta": [1, -2.5, true, null, "short", "a string longer than eight bytes"], "alpha": {"b": {}, "a": []}, "mid": "", "n": -9223372036854775807})");
+		std::string image = v.serialize_frozen();
+		TEST(image.size() % 8 == 0)
+		
+		aeon::frozen f { image };
+		aeon::frozen::value root = f.root();
+		TEST(root.is_map() && root.size() == 4)
+		TEST(root["zeta"].is_array() && root["zeta"].size() == 6)
+		TEST(root["zeta"][0].integer() == 1)
+		TEST(root["zeta"][1].floating() == -2.5)
+		TEST(root["zeta"][2].boolean())
+		TEST(root["zeta"][3].is_null())
+		TEST(root["zeta"][4].string() == "short")
+		TEST(root["zeta"][5].string() == "a string longer than eight bytes")
+		TEST(root["zeta"][6].is_null() && root["zeta"]["x"].is_null())
+		TEST(root["mid"].is_string() && root["mid"].string().empty())
+		TEST(root["n"].integer() == -9223372036854775807)
+		TEST(root["alpha"]["a"].is_array() && root["alpha"]["b"].is_map() && root["alpha"]["a"].size() == 0)
+		TEST(root.contains("alpha") && !root.contains("alphb") && !root.contains("") && root["nope"].is_null())
+		TEST(root["zeta"][0].string().empty() && !root["mid"].boolean() && root["mid"].integer() == 0)
+		
+		TEST(root.entry(0).first == "alpha" && root.entry(1).first == "mid" && root.entry(2).first == "n" && root.entry(3).first == "zeta")
+		TEST(root.entry(3).second[4].string() == "short" && root.entry(4).first.empty())
+		TEST(root.thaw() == v)
+		TEST(aeon::frozen { aeon { 5 }.serialize_frozen() }.root().integer() == 5)
+		TEST(aeon::frozen { aeon {}.serialize_frozen() }.root().is_null())
+		
+		aeon wide;
+		for (int i = 0; i < 1000; i++) wide[meadow::strf("key%i", i * 7)] = i;
+		std::string wide_image = wide.serialize_frozen();
+		aeon::frozen::value wide_root = aeon::frozen { wide_image }.root();
+		bool found = true;
+		for (int i = 0; i < 1000; i++) {
+			found = found && wide_root[meadow::strf("key%i", i * 7)].integer() == i;
+			found = found && !wide_root.contains(meadow::strf("key%i", i * 7 + 1));
+		}
+		TEST(found)
+		
+		char path [] = "/tmp/meadow_frozen_XXXXXX";
+		int fd = ::mkstemp(path);
+		TEST(fd >= 0)
+		v.serialize_frozen(fd);
+		::close(fd);
+		aeon::frozen mapped = aeon::frozen::open(path);
+		::unlink(path);
+		aeon::frozen copy = mapped;
+		mapped = aeon::frozen { image };
+		TEST(copy.root()["zeta"][5].string() == "a string longer than eight bytes")
+		TEST(copy.root().thaw() == v)
+		
+		meadow::buffer buf;
+		v.serialize_frozen(buf);
+		TEST(std::string_view(reinterpret_cast<char const *>(buf.data()), buf.size()) == image)
+		
+		auto corrupt = [](std::string const & img, auto && fn) {
+			try {
+				fn(aeon::frozen { img }.root());
+			} catch (aeon::deserialize_exception const &) {
+				return true;
+			}
+			return false;
+		};
+		TEST(corrupt("", [](auto){}))
+		TEST(corrupt(image.substr(0, image.size() - 8), [](auto){}))
+		std::string bad_magic = image;
+		bad_magic[0] = 'X';
+		TEST(corrupt(bad_magic, [](auto){}))
+		std::string bad_type = image;
+		bad_type[16] = 42;
+		TEST(corrupt(bad_type, [](auto r){ (void)r.type(); }))
+		std::string bad_offset = image;
+		uint64_t far = 1 << 30;
+		std::memcpy(bad_offset.data() + 24, &far, 8);
+		TEST(corrupt(bad_offset, [](auto r){ (void)r["zeta"]; }))
+		TEST(corrupt(bad_offset, [](auto r){ (void)r.thaw(); }))
+		
+		// a container whose payload points back at itself or at an earlier slot
+		std::string nested = aeon::deserialize_json("[[[1]]]").serialize_frozen();
+		for (uint64_t back : { uint64_t(16), uint64_t(32), uint64_t(0) }) {
+			std::string cycle = nested;
+			std::memcpy(cycle.data() + 32 + 8, &back, 8);
+			TEST(corrupt(cycle, [](auto r){ (void)r.thaw(); }))
+			TEST(corrupt(cycle, [](auto r){ (void)r[0][0]; }))
+		}
+		aeon deep;
+		aeon * tip = &deep;
+		for (int i = 0; i < 1024; i++) tip = &tip->array().emplace_back();
+		TEST(aeon::frozen { deep.serialize_frozen() }.root().thaw() == deep)
+		tip->array();
+		bool too_deep = false;
+		try {
+			(void)deep.serialize_frozen();
+		} catch (std::length_error const &) {
+			too_deep = true;
+		}
+		TEST(too_deep)
+	}
+	
+	// STRICT PARSING
+	{
+		aeon::limits lim;
+		auto strict_ok = [&](std::string_view json) {
+			try {
+				aeon::validate_json(json, lim);
+				return aeon::deserialize_json(json, lim) == aeon::deserialize_json(json);
+			} catch (aeon::deserialize_exception const &) {
+				return false;
+			}
+		};
+		// both the validator and the parser must reject, and with the same kind of exception
+		auto rejects = [&](std::string_view json, bool limit) {
+			auto check = [&](auto && fn) {
+				try {
+					fn();
+				} catch (aeon::limit_exception const &) {
+					return limit;
+				} catch (aeon::deserialize_exception const &) {
+					return !limit;
+				}
+				return false;
+			};
+			return check([&]{ aeon::validate_json(json, lim); }) && check([&]{ (void)aeon::deserialize_json(json, lim); });
+		};
+		
+		TEST(strict_ok(R"({"a": [1, -2.5e+3, 0, -0.0, true, false, null, "s\n\u00e9"], "b": {}, "c": [], "d": {"e": [[]]}})"))
+		TEST(strict_ok(" 12 ") && strict_ok("\"x\"") && strict_ok("[]") && strict_ok("1E5") && strict_ok("99999999999999999999"))
+		
+		for (char const * bad : {"[1 2]", "[1,]", "[,1]", "[1,,2]", "{\"a\" 1}", "{\"a\":1,}", "{,}", "{\"a\",1}", "{\"a\":1 \"b\":2}", "[1]]", "[1] 2", "1 2", "{} x",
+		                         "01", "1.", ".5", "+1", "-", "1e", "1e+", "-01", "1.e5", "[1:2]", "{\"a\"::1}", "", "   ", "[", "{\"a\":", "\"\\x\"", "nul"})
+			TEST(rejects(bad, false))
+		
+		// the default parser stays lenient about separators
+		TEST(aeon::deserialize_json("[1 2]") == aeon::deserialize_json("[1, 2]"))
+		
+		std::string deep = std::string(100000, '[') + std::string(100000, ']');
+		TEST(rejects(deep, true))
+		lim.max_depth = 3;
+		TEST(strict_ok("[[[1]]]") && strict_ok("{\"a\": [{}]}"))
+		TEST(rejects("[[[[1]]]]", true) && rejects("{\"a\": [{\"b\": []}]}", true))
+		
+		lim = {};
+		lim.max_string = 4;
+		TEST(strict_ok(R"({"abcd": "wxyz"})"))
+		TEST(rejects(R"({"abcde": 1})", true) && rejects(R"(["wxyz!"])", true) && rejects(R"(["\n\n\n"])", true))
+		
+		lim = {};
+		lim.max_number = 4;
+		TEST(strict_ok("[1234, -123, 1.25]"))
+		TEST(rejects("[12345]", true) && rejects("-1234", true) && rejects("1.2e5", true))
+		
+		lim = {};
+		lim.max_nodes = 4;
+		TEST(strict_ok("[1, 2, 3]") && strict_ok(R"({"a": {"b": 1}, "c": 2})"))
+		TEST(rejects("[1, 2, 3, 4]", true) && rejects("[[], [], [], []]", true))
+		
+		lim = {};
+		lim.max_input = 8;
+		TEST(strict_ok("[1, 2]  "))
+		TEST(rejects("[1, 2]   ", true))
+		
+		// limits are checked before anything past them is built
+		lim = {};
+		lim.max_nodes = 1000;
+		std::string huge = "[" + std::string(10000000, ' ');
+		for (int i = 0; i < 2000; i++) huge += "[],";
+		huge += "[]]";
+		TEST(rejects(huge, true))
+		
+		// the index itself stops growing once it holds more tokens than that many values could take
+		lim.max_nodes = 10;
+		std::string ones = "[";
+		for (int i = 0; i < 1000; i++) ones += "1,";
+		ones += "1]";
+		bool indexed = true;
+		try {
+			aeon::reader early { ones, lim };
+		} catch (aeon::limit_exception const &) {
+			indexed = false;
+		}
+		TEST(!indexed)
+		TEST(strict_ok(R"({"a": "b", "c": "d", "e": "f", "g": "h", "i": "j", "k": "l", "m": "n", "o": "p", "q": "r"})"))
+		
+		lim = {};
+		aeon::document doc;
+		TEST(aeon::deserialize_json(R"({"a": [1, 2]})", doc, lim)["a"][1] == 2)
+		
+		aeon::reader r { "[1, 2 3]", lim };
+		TEST(r.next() && r.event() == aeon::event_t::start_array)
+		TEST(r.next() && r.integer() == 1)
+		TEST(r.next() && r.integer() == 2)
+		bool threw = false;
+		try { r.next(); } catch (aeon::deserialize_exception const &) { threw = true; }
+		TEST(threw)
+	}
+	
+	// OUTPUT FORMATS
+	{
+		aeon v = aeon::deserialize_json(R"({"b": [1, {"y": null, "x": -0.0}], "a": {}, "c": [], "d": "\u00e9"})");
+		
+		aeon::format pretty;
+		pretty.indent = 2;
+		TEST(v.serialize_json(pretty) == "{\n  \"b\": [\n    1,\n    {\n      \"y\": null,\n      \"x\": -0.0\n    }\n  ],\n  \"a\": {},\n  \"c\": [],\n  \"d\": \"\u00e9\"\n}")
+		TEST(aeon::deserialize_json(v.serialize_json(pretty)) == v)
+		TEST(v.serialize_json(aeon::format {}) == v.serialize_json())
+		
+		aeon::format canonical;
+		canonical.canonical = true;
+		TEST(v.serialize_json(canonical) == R"({"a":{},"b":[1,{"x":0.0,"y":null}],"c":[],"d":"é"})")
+		aeon reordered = aeon::deserialize_json(R"({"d": "\u00e9", "c": [], "a": {}, "b": [1, {"x": 0.0, "y": null}]})");
+		TEST(reordered.serialize_json(canonical) == v.serialize_json(canonical))
+		TEST(reordered.serialize_json() != v.serialize_json())
+		
+		// the key ordering example of RFC 8785, section 3.2.3
+		aeon keys = aeon::deserialize_json(R"({"\u20ac": 0, "\r": 1, "\ufb33": 2, "1": 3, "\ud83d\ude00": 4, "\u0080": 5, "\u00f6": 6})");
+		aeon sorted = aeon::deserialize_json(keys.serialize_json(canonical));
+		std::vector<aeon::int_t> key_order;
+		for (auto const & [key, value] : sorted.map()) key_order.push_back(value.integer());
+		TEST((key_order == std::vector<aeon::int_t> { 1, 3, 5, 6, 0, 4, 2 }))
+		
+		aeon::format ascii;
+		ascii.ascii = true;
+		aeon text { std::string_view { "caf\xc3\xa9 \xf0\x9f\x98\x80 \"\n" } };
+		TEST(text.serialize_json(ascii) == R"("caf\u00e9 \ud83d\ude00 \"\n")")
+		TEST(aeon::deserialize_json(text.serialize_json(ascii)) == text)
+		TEST(aeon { std::string_view { "\xff|\xe2\x82|\xc0\xaf|\xed\xa0\x80" } }.serialize_json(ascii) == R"("\ufffd|\ufffd\ufffd|\ufffd\ufffd|\ufffd\ufffd\ufffd")")
+		aeon ascii_keys;
+		ascii_keys["\xc3\xa9"] = 1;
+		TEST(ascii_keys.serialize_json(ascii) == R"({"\u00e9":1})")
+		
+		aeon::format all { 1, true, true };
+		TEST(aeon::deserialize_json(keys.serialize_json(all)) == keys)
+		std::string streamed;
+		meadow::buffer buf;
+		keys.serialize_json(all, buf);
+		keys.serialize_json(all, [](void * ctx, char const * data, size_t size){ reinterpret_cast<std::string *>(ctx)->append(data, size); }, &streamed);
+		TEST(streamed == keys.serialize_json(all))
+		TEST(std::string_view(reinterpret_cast<char const *>(buf.data()), buf.size()) == streamed)
+		
+		aeon lazy = aeon::deserialize_json_lazy(R"({"z": {"b": 1, "a": 2}})");
+		TEST(lazy.serialize_json(canonical) == R"({"z":{"a":2,"b":1}})")
+	}
+	
 	// BRUTE FORCE SEGFAULT TESTING
 	{
 		constexpr char gen_chars [] = {"abcdefg0123456789\"\r\n ,:.[][][][][][]{}{}{}{}{}{}{}{}{}{}{}"};
@@ -143,4 +1397,882 @@ void test_aeon() {
 	}
 	
 	test.array() = {4, 4, 3};
+	
+	{ // VALUE REPRESENTATION MEMORY
+		constexpr size_t ECOUNT = 1000000;
+		
+		static_assert(sizeof(aeon) == 16);
+		
+		std::string json = "[";
+		for (size_t i = 0; i < ECOUNT; i++) {
+			if (i) json += ',';
+			json += std::to_string(rndnum<int64_t>(-1000000, 1000000));
+		}
+		json += "]";
+		
+		tlog << "================================================================";
+		tlog << "Running value representation memory tests";
+		tlog << ECOUNT << " element numeric array, " << json.size() << " bytes.";
+		tlog << "----------------";
+		
+		auto heap_in_use = [](){ auto mi = mallinfo2(); return mi.uordblks + mi.hblkhd; };
+		
+		size_t heap_before = heap_in_use();
+		size_t allocs_before = alloc_count;
+		{
+			aeon v = aeon::deserialize_json(json);
+			size_t allocs = alloc_count - allocs_before;
+			size_t heap = heap_in_use() - heap_before;
+			tlog << "Allocations: " << allocs;
+			tlog << "Heap In Use: " << heap / 1024 << " KiB (" << static_cast<double>(heap) / ECOUNT << " bytes per element)";
+			TEST(v.size() == ECOUNT)
+			TEST(allocs < 100)
+			
+			allocs_before = alloc_count;
+			aeon moved { std::move(v) };
+			aeon copied;
+			copied = std::move(moved);
+			TEST(alloc_count == allocs_before)
+			TEST(copied.size() == ECOUNT)
+		}
+		
+		tlog << "================================================================";
+	}
+	
+	{ // BORROWED PARSING ALLOCATIONS
+		constexpr size_t SCOUNT = 100000;
+		
+		std::string json = "[";
+		for (size_t i = 0; i < SCOUNT; i++) {
+			if (i) json += ',';
+			json += meadow::strf("\"a string value long enough to need the heap, number %zu\"", i);
+		}
+		json += "]";
+		
+		tlog << "================================================================";
+		tlog << "Running borrowed parsing allocation tests";
+		tlog << SCOUNT << " element string array, " << json.size() << " bytes.";
+		tlog << "----------------";
+		
+		size_t allocs_before = alloc_count;
+		{
+			aeon v = aeon::deserialize_json(json);
+			tlog << "Owned Allocations: " << alloc_count - allocs_before;
+		}
+		allocs_before = alloc_count;
+		{
+			aeon v = aeon::deserialize_json_borrowed(json);
+			size_t allocs = alloc_count - allocs_before;
+			tlog << "Borrowed Allocations: " << allocs;
+			TEST(allocs < 100)
+		}
+		
+		tlog << "================================================================";
+	}
+	
+	{ // KEY INTERNING MEMORY
+		constexpr size_t RCOUNT = 100000;
+		
+		std::string json = "[";
+		for (size_t i = 0; i < RCOUNT; i++) {
+			if (i) json += ',';
+			json += meadow::strf("{\"identifier\":%zu,\"description\":\"r\",\"timestamp_ms\":%zu,\"is_enabled\":true}", i, i * 1000);
+		}
+		json += "]";
+		
+		auto heap = [](){ struct mallinfo2 mi = mallinfo2(); return mi.uordblks + mi.hblkhd; };
+		
+		tlog << "================================================================";
+		tlog << "Running key interning memory tests";
+		tlog << RCOUNT << " records of 4 keys, " << json.size() << " bytes.";
+		tlog << "----------------";
+		
+		size_t allocs_before = alloc_count;
+		size_t heap_before = heap();
+		size_t plain_allocs;
+		{
+			aeon v = aeon::deserialize_json(json);
+			plain_allocs = alloc_count - allocs_before;
+			tlog << "Plain Allocations: " << plain_allocs;
+			tlog << "Plain Heap In Use: " << (heap() - heap_before) / 1024 << " KiB";
+		}
+		
+		aeon::key_pool pool;
+		aeon::key_pool::scope scope { pool };
+		allocs_before = alloc_count;
+		heap_before = heap();
+		{
+			aeon v = aeon::deserialize_json(json);
+			size_t allocs = alloc_count - allocs_before;
+			tlog << "Interned Allocations: " << allocs;
+			tlog << "Interned Heap In Use: " << (heap() - heap_before) / 1024 << " KiB";
+			TEST(allocs + RCOUNT * 4 <= plain_allocs + 100)
+			TEST(pool.size() == 4)
+		}
+		
+		tlog << "================================================================";
+	}
+	
+	{ // DESERIALIZATION PERFORMANCE
+		constexpr size_t RCOUNT = 100000;
+		constexpr size_t TCOUNT = 10;
+		
+		aeon doc;
+		for (size_t i = 0; i < RCOUNT; i++) {
+			aeon & rec = doc[i];
+			rec["id"] = i;
+			rec["name"] = meadow::strf("record number %zu", i);
+			rec["score"] = i * 0.25;
+			rec["tags"][0] = "alpha";
+			rec["tags"][1] = "beta";
+			rec["flag"].boolean() = i % 2;
+		}
+		std::string json = doc.serialize_json();
+		
+		meadow::time<CLOCK_PROCESS_CPUTIME_ID>::keeper tk;
+		
+		tlog << "================================================================";
+		tlog << "Running JSON deserialization performance tests";
+		tlog << TCOUNT << " iterations of " << json.size() << " bytes.";
+		tlog << "----------------";
+		
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			auto v = aeon::deserialize_json(json);
+			benchmark::DoNotOptimize(v);
+		}
+		auto t = tk.mark().seconds();
+		tlog << "Deserialize: " << t << "s (" << json.size() * TCOUNT / t / 1048576 << " MiB/s)";
+		
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			aeon::document doc;
+			aeon::deserialize_json(json, doc);
+			benchmark::DoNotOptimize(doc);
+		}
+		t = tk.mark().seconds();
+		tlog << "Deserialize Document: " << t << "s (" << json.size() * TCOUNT / t / 1048576 << " MiB/s)";
+		
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			auto v = aeon::deserialize_json_borrowed(json);
+			benchmark::DoNotOptimize(v);
+		}
+		t = tk.mark().seconds();
+		tlog << "Deserialize Borrowed: " << t << "s (" << json.size() * TCOUNT / t / 1048576 << " MiB/s)";
+		
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			aeon::document doc;
+			aeon::deserialize_json_borrowed(json, doc);
+			benchmark::DoNotOptimize(doc);
+		}
+		t = tk.mark().seconds();
+		tlog << "Deserialize Borrowed Document: " << t << "s (" << json.size() * TCOUNT / t / 1048576 << " MiB/s)";
+		
+		struct null_handler : aeon::handler {} h;
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			aeon::deserialize_json(json, h);
+		}
+		t = tk.mark().seconds();
+		tlog << "Deserialize Events: " << t << "s (" << json.size() * TCOUNT / t / 1048576 << " MiB/s)";
+		
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			aeon::parser p;
+			for (size_t pos = 0; pos < json.size(); pos += 4096)
+				p.feed(json.data() + pos, std::min<size_t>(4096, json.size() - pos));
+			p.finish();
+			benchmark::DoNotOptimize(p.pop());
+		}
+		t = tk.mark().seconds();
+		tlog << "Deserialize Incremental (4 KiB pieces): " << t << "s (" << json.size() * TCOUNT / t / 1048576 << " MiB/s)";
+		
+		tlog << "----------------";
+		
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			auto v = doc.serialize_json();
+			benchmark::DoNotOptimize(v);
+		}
+		t = tk.mark().seconds();
+		tlog << "Serialize String: " << t << "s (" << json.size() * TCOUNT / t / 1048576 << " MiB/s)";
+		
+		meadow::buffer buf;
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			buf.clear();
+			doc.serialize_json(buf);
+			benchmark::DoNotOptimize(buf);
+		}
+		t = tk.mark().seconds();
+		tlog << "Serialize Buffer: " << t << "s (" << json.size() * TCOUNT / t / 1048576 << " MiB/s)";
+		
+		int devnull = open("/dev/null", O_WRONLY);
+		size_t allocs_before = alloc_count;
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			doc.serialize_json(devnull);
+		}
+		t = tk.mark().seconds();
+		TEST(alloc_count == allocs_before)
+		close(devnull);
+		tlog << "Serialize File Descriptor: " << t << "s (" << json.size() * TCOUNT / t / 1048576 << " MiB/s)";
+		
+		tlog << "----------------";
+		std::string bin = doc.serialize_binary();
+		tlog << "Binary Size: " << bin.size() << " bytes (" << 100.0 * bin.size() / json.size() << "% of JSON)";
+		
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			benchmark::DoNotOptimize(doc.serialize_binary());
+		}
+		t = tk.mark().seconds();
+		tlog << "Serialize Binary: " << t << "s (" << bin.size() * TCOUNT / t / 1048576 << " MiB/s, " << RCOUNT * TCOUNT / t << " records/s)";
+		
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			benchmark::DoNotOptimize(aeon::deserialize_binary(bin));
+		}
+		t = tk.mark().seconds();
+		tlog << "Deserialize Binary: " << t << "s (" << bin.size() * TCOUNT / t / 1048576 << " MiB/s, " << RCOUNT * TCOUNT / t << " records/s)";
+		
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			aeon::document d;
+			aeon::deserialize_binary(bin, d);
+			benchmark::DoNotOptimize(d);
+		}
+		t = tk.mark().seconds();
+		tlog << "Deserialize Binary Document: " << t << "s (" << bin.size() * TCOUNT / t / 1048576 << " MiB/s, " << RCOUNT * TCOUNT / t << " records/s)";
+		
+		tlog << "================================================================";
+	}
+	
+	{ // NUMERIC PERFORMANCE
+		constexpr size_t ECOUNT = 1000000;
+		constexpr size_t TCOUNT = 10;
+		
+		aeon doc;
+		aeon::ary_t & ary = doc.array();
+		ary.reserve(ECOUNT);
+		for (size_t i = 0; i < ECOUNT; i++) {
+			if (i % 2) ary.emplace_back(rndnum<aeon::int_t>(-1000000000, 1000000000));
+			else ary.emplace_back(rndnum<aeon::int_t>(-1000000000000, 1000000000000) / 1e6);
+		}
+		std::string json = doc.serialize_json();
+		TEST(aeon::deserialize_json(json) == doc)
+		
+		meadow::time<CLOCK_PROCESS_CPUTIME_ID>::keeper tk;
+		
+		tlog << "================================================================";
+		tlog << "Running numeric performance tests";
+		tlog << TCOUNT << " iterations of " << ECOUNT << " mixed integers and floats, " << json.size() << " bytes.";
+		tlog << "----------------";
+		
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			aeon::document d;
+			aeon::deserialize_json(json, d);
+			benchmark::DoNotOptimize(d);
+		}
+		double t = tk.mark().seconds();
+		tlog << "Deserialize Numbers: " << t << "s (" << ECOUNT * TCOUNT / t / 1000000 << " M numbers/s)";
+		
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			benchmark::DoNotOptimize(doc.serialize_json());
+		}
+		t = tk.mark().seconds();
+		tlog << "Serialize Numbers: " << t << "s (" << ECOUNT * TCOUNT / t / 1000000 << " M numbers/s)";
+		
+		tlog << "================================================================";
+	}
+	
+	{ // MAP PERFORMANCE
+		constexpr size_t LCOUNT = 10000000;
+		
+		meadow::time<CLOCK_PROCESS_CPUTIME_ID>::keeper tk;
+		
+		tlog << "================================================================";
+		tlog << "Running map lookup and iteration performance tests";
+		tlog << LCOUNT << " lookups and " << LCOUNT << " iterated entries per size.";
+		
+		for (size_t size : {4, 16, 64, 1024}) {
+			std::vector<std::string> keys;
+			for (size_t i = 0; i < size; i++) keys.push_back(meadow::strf("field_%zu", i * 7919));
+			
+			aeon::map_t flat;
+			std::unordered_map<std::string, aeon> hashed;
+			for (size_t i = 0; i < size; i++) {
+				flat[keys[i]] = i;
+				hashed[keys[i]] = i;
+			}
+			
+			tlog << "----------------";
+			tlog << size << " keys";
+			
+			aeon::int_t sum = 0;
+			tk.mark();
+			for (size_t i = 0; i < LCOUNT; i++) sum += flat.find(keys[i % size])->second.integer();
+			double t = tk.mark().seconds();
+			benchmark::DoNotOptimize(sum);
+			tlog << "Lookup Flat: " << t << "s (" << LCOUNT / t / 1000000 << " M/s)";
+			
+			tk.mark();
+			for (size_t i = 0; i < LCOUNT; i++) sum += hashed.find(keys[i % size])->second.integer();
+			t = tk.mark().seconds();
+			benchmark::DoNotOptimize(sum);
+			tlog << "Lookup std::unordered_map: " << t << "s (" << LCOUNT / t / 1000000 << " M/s)";
+			
+			tk.mark();
+			for (size_t i = 0; i < LCOUNT / size; i++) for (auto const & [key, value] : flat) sum += value.integer() + key.size();
+			t = tk.mark().seconds();
+			benchmark::DoNotOptimize(sum);
+			tlog << "Iterate Flat: " << t << "s (" << LCOUNT / t / 1000000 << " M/s)";
+			
+			tk.mark();
+			for (size_t i = 0; i < LCOUNT / size; i++) for (auto const & [key, value] : hashed) sum += value.integer() + key.size();
+			t = tk.mark().seconds();
+			benchmark::DoNotOptimize(sum);
+			tlog << "Iterate std::unordered_map: " << t << "s (" << LCOUNT / t / 1000000 << " M/s)";
+		}
+		
+		tlog << "================================================================";
+	}
+	
+	{ // SCHEMA BINDING PERFORMANCE
+		constexpr size_t RCOUNT = 200000;
+		constexpr size_t TCOUNT = 4;
+		
+		std::string json = "[";
+		for (size_t i = 0; i < RCOUNT; i++) {
+			if (i) json += ',';
+			json += meadow::strf("{\"id\":%zu,\"name\":\"record number %zu\",\"score\":%g,\"tags\":[\"alpha\",\"beta\"],\"flag\":%s}", i, i, i * 0.25, i % 2 ? "true" : "false");
+		}
+		json += "]";
+		
+		meadow::time<CLOCK_PROCESS_CPUTIME_ID>::keeper tk;
+		
+		tlog << "================================================================";
+		tlog << "Running schema binding performance tests";
+		tlog << TCOUNT << " iterations of " << RCOUNT << " records, " << json.size() << " bytes.";
+		tlog << "----------------";
+		
+		std::vector<bind_bench> records;
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			aeon tree = aeon::deserialize_json(json);
+			records.clear();
+			for (aeon const & v : tree.array()) {
+				bind_bench & r = records.emplace_back();
+				r.id = v["id"].as_integer();
+				r.name = v["name"].as_string();
+				r.score = v["score"].as_floating();
+				for (aeon const & tag : v["tags"].array()) r.tags.emplace_back(tag.string());
+				r.flag = v["flag"].as_boolean();
+			}
+			benchmark::DoNotOptimize(records);
+		}
+		double t = tk.mark().seconds();
+		tlog << "Deserialize Tree, Then Convert: " << t << "s (" << json.size() * TCOUNT / t / 1048576 << " MiB/s)";
+		
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			meadow::binding::deserialize_json(json, records);
+			benchmark::DoNotOptimize(records);
+		}
+		t = tk.mark().seconds();
+		TEST(records.size() == RCOUNT && records.back().tags.size() == 2)
+		tlog << "Deserialize Bound: " << t << "s (" << json.size() * TCOUNT / t / 1048576 << " MiB/s)";
+		
+		tlog << "----------------";
+		
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			aeon tree;
+			aeon::ary_t & ary = tree.array();
+			for (bind_bench const & r : records) {
+				aeon & v = ary.emplace_back();
+				v["id"] = r.id;
+				v["name"] = r.name;
+				v["score"] = r.score;
+				aeon::ary_t & tags = v["tags"].array();
+				for (std::string const & tag : r.tags) tags.emplace_back(tag);
+				v["flag"] = r.flag;
+			}
+			std::string out = tree.serialize_json();
+			benchmark::DoNotOptimize(out);
+		}
+		t = tk.mark().seconds();
+		tlog << "Convert To Tree, Then Serialize: " << t << "s (" << json.size() * TCOUNT / t / 1048576 << " MiB/s)";
+		
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			std::string out = meadow::binding::serialize_json(records);
+			benchmark::DoNotOptimize(out);
+		}
+		t = tk.mark().seconds();
+		tlog << "Serialize Bound: " << t << "s (" << json.size() * TCOUNT / t / 1048576 << " MiB/s)";
+		
+		tlog << "================================================================";
+	}
+	
+	{ // PATH PERFORMANCE
+		constexpr size_t RCOUNT = 100000;
+		constexpr size_t TCOUNT = 20;
+		
+		std::string json = "[";
+		for (size_t i = 0; i < RCOUNT; i++) {
+			if (i) json += ',';
+			json += meadow::strf(R"({"id":%zu,"meta":{"name":"record %zu","flags":[true,false]},"a":{"z":0,"b":[0,1,2,{"y":1,"c":%zu}]}})", i, i, i);
+		}
+		json += "]";
+		aeon const doc = aeon::deserialize_json(json);
+		aeon::ary_t const & records = doc.array();
+		
+		meadow::time<CLOCK_PROCESS_CPUTIME_ID>::keeper tk;
+		
+		tlog << "================================================================";
+		tlog << "Running path query performance tests";
+		tlog << TCOUNT << " iterations of " << RCOUNT << " lookups of /a/b/3/c.";
+		tlog << "----------------";
+		
+		aeon::int_t sum = 0;
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			for (aeon const & r : records) sum += r["a"]["b"][3]["c"].integer();
+		}
+		double t = tk.mark().seconds();
+		tlog << "Chained operator []: " << t << "s (" << RCOUNT * TCOUNT / t / 1000000 << " M/s)";
+		
+		aeon::path const p { "/a/b/3/c" };
+		aeon::int_t path_sum = 0;
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			for (aeon const & r : records) path_sum += p.find(r)->integer();
+		}
+		t = tk.mark().seconds();
+		TEST(path_sum == sum)
+		tlog << "Path: " << t << "s (" << RCOUNT * TCOUNT / t / 1000000 << " M/s)";
+		
+		std::vector<aeon const *> results (RCOUNT);
+		path_sum = 0;
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			p.find(records.data(), records.size(), results.data());
+			for (aeon const * v : results) path_sum += v->integer();
+		}
+		t = tk.mark().seconds();
+		TEST(path_sum == sum)
+		tlog << "Path Batch: " << t << "s (" << RCOUNT * TCOUNT / t / 1000000 << " M/s)";
+		
+		tlog << "----------------";
+		
+		constexpr size_t SCOUNT = 4;
+		aeon::path const last { meadow::strf("/%zu/a/b/3/c", RCOUNT - 1) };
+		tk.mark();
+		for (size_t i = 0; i < SCOUNT; i++) {
+			aeon tree = aeon::deserialize_json(json);
+			benchmark::DoNotOptimize(tree[last]);
+		}
+		t = tk.mark().seconds();
+		tlog << "Deserialize, Then Query Last Record: " << t << "s (" << json.size() * SCOUNT / t / 1048576 << " MiB/s)";
+		
+		aeon::int_t selected = 0;
+		tk.mark();
+		for (size_t i = 0; i < SCOUNT; i++) {
+			last.select_json(json, [&](aeon && v){ selected = v.integer(); });
+		}
+		t = tk.mark().seconds();
+		TEST(selected == static_cast<aeon::int_t>(RCOUNT - 1))
+		tlog << "Streaming Select Last Record: " << t << "s (" << json.size() * SCOUNT / t / 1048576 << " MiB/s)";
+		
+		size_t count = 0;
+		tk.mark();
+		for (size_t i = 0; i < SCOUNT; i++) {
+			aeon::path("/*/meta/name").select_json(json, [&](aeon && v){ count++; benchmark::DoNotOptimize(v); });
+		}
+		t = tk.mark().seconds();
+		TEST(count == RCOUNT * SCOUNT)
+		tlog << "Streaming Select /*/meta/name: " << t << "s (" << json.size() * SCOUNT / t / 1048576 << " MiB/s)";
+		
+		tlog << "================================================================";
+	}
+	
+	{ // LAZY PARSING PERFORMANCE
+		constexpr size_t ICOUNT = 20000;
+		constexpr size_t TCOUNT = 20;
+		
+		std::string json = R"({"route": "/v1/items", "user": {"id": 42, "name": "someone"}, "items": [)";
+		for (size_t i = 0; i < ICOUNT; i++) {
+			if (i) json += ',';
+			json += meadow::strf(R"({"id":%zu,"name":"item %zu","price":%g,"tags":["a","b"]})", i, i, i * 0.5);
+		}
+		json += R"(], "trace": {"span": "abc", "parent": null}})";
+		
+		meadow::time<CLOCK_PROCESS_CPUTIME_ID>::keeper tk;
+		
+		tlog << "================================================================";
+		tlog << "Running lazy parsing performance tests";
+		tlog << TCOUNT << " iterations of " << json.size() << " bytes, touching 3 fields.";
+		tlog << "----------------";
+		
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			aeon v = aeon::deserialize_json(json);
+			benchmark::DoNotOptimize(v["route"].string());
+			benchmark::DoNotOptimize(v["user"]["id"].integer());
+			benchmark::DoNotOptimize(v["trace"]["span"].string());
+		}
+		double t = tk.mark().seconds();
+		tlog << "Deserialize: " << t << "s (" << json.size() * TCOUNT / t / 1048576 << " MiB/s)";
+		
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			aeon v = aeon::deserialize_json_lazy(json);
+			benchmark::DoNotOptimize(v["route"].string());
+			benchmark::DoNotOptimize(v["user"]["id"].integer());
+			benchmark::DoNotOptimize(v["trace"]["span"].string());
+		}
+		t = tk.mark().seconds();
+		tlog << "Deserialize Lazy: " << t << "s (" << json.size() * TCOUNT / t / 1048576 << " MiB/s)";
+		
+		// each level of a deep input padded with data that is never looked at
+		std::string ones = "1";
+		for (size_t i = 0; i < 500; i++) ones += ",1";
+		std::string deep;
+		for (size_t i = 0; i < 500; i++) deep += R"({"pad": [)" + ones + R"(], "next": )";
+		deep += "0";
+		for (size_t i = 0; i < 500; i++) deep += "}";
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			aeon v = aeon::deserialize_json_lazy(deep);
+			aeon const * at = &v;
+			while ((*at)["next"].is_map()) at = &(*at)["next"];
+			benchmark::DoNotOptimize(at);
+		}
+		t = tk.mark().seconds();
+		tlog << "Descend Lazy 500 Levels: " << t / TCOUNT * 1000 << "ms (" << deep.size() << " bytes)";
+		
+		tlog << "----------------";
+		
+		aeon eager = aeon::deserialize_json(json);
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			eager["user"]["seen"] = true;
+			std::string out = eager.serialize_json();
+			benchmark::DoNotOptimize(out);
+		}
+		t = tk.mark().seconds();
+		tlog << "Modify And Serialize: " << t << "s (" << json.size() * TCOUNT / t / 1048576 << " MiB/s)";
+		
+		aeon lazy = aeon::deserialize_json_lazy(json);
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			lazy["user"]["seen"] = true;
+			std::string out = lazy.serialize_json();
+			benchmark::DoNotOptimize(out);
+		}
+		t = tk.mark().seconds();
+		TEST(lazy.map().at("items").is_lazy() && lazy == eager)
+		tlog << "Modify And Serialize Lazy: " << t << "s (" << json.size() * TCOUNT / t / 1048576 << " MiB/s)";
+		
+		tlog << "================================================================";
+	}
+	
+	{ // DIFF PERFORMANCE
+		constexpr size_t SCOUNT = 1000;
+		constexpr size_t KCOUNT = 100;
+		constexpr size_t TCOUNT = 10;
+		
+		aeon config;
+		for (size_t i = 0; i < SCOUNT; i++) {
+			aeon & section = config[meadow::strf("section %zu", i)];
+			for (size_t j = 0; j < KCOUNT; j++) section[meadow::strf("key %zu", j)] = meadow::strf("value %zu.%zu", i, j);
+		}
+		aeon changed = config;
+		changed["section 17"]["key 3"] = 1;
+		changed["section 500"].map().erase("key 50");
+		changed["section 999"]["extra"] = true;
+		std::string full = changed.serialize_json();
+		
+		meadow::time<CLOCK_PROCESS_CPUTIME_ID>::keeper tk;
+		
+		tlog << "================================================================";
+		tlog << "Running diff and patch performance tests";
+		tlog << TCOUNT << " iterations over " << SCOUNT * KCOUNT << " leaves with 3 changes.";
+		tlog << "----------------";
+		
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			std::string out = changed.serialize_json();
+			benchmark::DoNotOptimize(out);
+		}
+		double t = tk.mark().seconds();
+		tlog << "Serialize Whole Tree: " << t / TCOUNT * 1000 << "ms (" << full.size() << " bytes)";
+		
+		tk.mark();
+		aeon patch = aeon::diff(config, changed);
+		t = tk.mark().seconds();
+		std::string patch_json = patch.serialize_json();
+		TEST(patch.size() == 3)
+		tlog << "Diff, Hashing Everything: " << t * 1000 << "ms (" << patch_json.size() << " bytes)";
+		
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			changed["section 250"]["key 25"] = static_cast<aeon::int_t>(i);
+			patch = aeon::diff(config, changed);
+			benchmark::DoNotOptimize(patch);
+		}
+		t = tk.mark().seconds();
+		TEST(patch.size() == 4)
+		tlog << "Diff After Another Change: " << t / TCOUNT * 1000 << "ms";
+		changed["section 250"]["key 25"] = std::string { "value 250.25" };
+		patch = aeon::diff(config, changed);
+		TEST(patch.size() == 3)
+		
+		std::vector<aeon> targets (TCOUNT, config);
+		tk.mark();
+		for (aeon & target : targets) target.apply_patch(patch);
+		t = tk.mark().seconds();
+		TEST(targets.back() == changed)
+		tlog << "Apply Patch: " << t / TCOUNT * 1000 << "ms";
+		
+		tlog << "================================================================";
+	}
+	
+	{ // HASHING PERFORMANCE
+		constexpr size_t RCOUNT = 200000;
+		
+		std::vector<aeon> docs;
+		docs.reserve(RCOUNT);
+		for (size_t i = 0; i < RCOUNT; i++)
+			docs.push_back(aeon::deserialize_json(meadow::strf(R"({"id":%zu,"name":"record %zu","score":%g,"tags":["alpha","beta"],"meta":{"a":1,"b":[1,2,3]}})", i % (RCOUNT / 2), i % (RCOUNT / 2), (i % (RCOUNT / 2)) * 0.25)));
+		aeon tree { aeon::ary_t { docs.begin(), docs.end() } };
+		aeon other = tree;
+		other.array().back()["meta"]["a"] = 2;
+		
+		meadow::time<CLOCK_PROCESS_CPUTIME_ID>::keeper tk;
+		
+		tlog << "================================================================";
+		tlog << "Running hashing performance tests";
+		tlog << RCOUNT << " records, half of them duplicates.";
+		tlog << "----------------";
+		
+		tk.mark();
+		bool equal = tree == other;
+		double t = tk.mark().seconds();
+		TEST(!equal)
+		tlog << "Compare Trees Differing At The End: " << t * 1000 << "ms";
+		
+		tk.mark();
+		uint64_t h = tree.hash();
+		t = tk.mark().seconds();
+		tlog << "Hash Tree: " << t * 1000 << "ms";
+		
+		TEST(tree.hash() == h)
+		
+		tlog << "----------------";
+		
+		tk.mark();
+		std::unordered_set<std::string> by_json;
+		for (aeon const & d : docs) by_json.insert(d.serialize_json());
+		t = tk.mark().seconds();
+		TEST(by_json.size() == RCOUNT / 2)
+		tlog << "Dedupe By Serialized JSON: " << t * 1000 << "ms";
+		
+		tk.mark();
+		std::unordered_set<aeon> by_value;
+		for (aeon & d : docs) by_value.insert(std::move(d));
+		t = tk.mark().seconds();
+		TEST(by_value.size() == RCOUNT / 2)
+		tlog << "Dedupe By Value: " << t * 1000 << "ms";
+		
+		tlog << "================================================================";
+	}
+	
+	{ // FROZEN PERFORMANCE
+		constexpr size_t RCOUNT = 200000;
+		constexpr size_t LCOUNT = 1000000;
+		
+		aeon tree;
+		for (size_t i = 0; i < RCOUNT; i++) {
+			aeon & r = tree[meadow::strf("user_%zu", i)];
+			r["id"] = static_cast<aeon::int_t>(i);
+			r["name"] = meadow::strf("record number %zu", i);
+			r["score"] = i * 0.25;
+			r["tags"].array() = { aeon { std::string_view { "alpha" } }, aeon { std::string_view { "beta" } } };
+		}
+		std::string json = tree.serialize_json();
+		std::string image = tree.serialize_frozen();
+		
+		std::vector<std::string> keys;
+		for (size_t i = 0; i < LCOUNT; i++) keys.push_back(meadow::strf("user_%zu", (i * 7919) % RCOUNT));
+		
+		char path [] = "/tmp/meadow_frozen_XXXXXX";
+		int fd = ::mkstemp(path);
+		TEST(fd >= 0)
+		TEST(::write(fd, image.data(), image.size()) == static_cast<ssize_t>(image.size()))
+		::close(fd);
+		
+		meadow::time<CLOCK_PROCESS_CPUTIME_ID>::keeper tk;
+		
+		tlog << "================================================================";
+		tlog << "Running frozen document performance tests";
+		tlog << RCOUNT << " records, " << json.size() << " bytes of JSON, " << image.size() << " bytes frozen.";
+		tlog << "----------------";
+		
+		tk.mark();
+		aeon parsed = aeon::deserialize_json(json);
+		aeon::int_t sum = parsed["user_12345"]["id"].integer();
+		double t = tk.mark().seconds();
+		tlog << "Startup, Parse JSON And Query: " << t * 1000 << "ms";
+		
+		tk.mark();
+		aeon::frozen mapped = aeon::frozen::open(path);
+		sum += mapped.root()["user_12345"]["id"].integer();
+		t = tk.mark().seconds();
+		tlog << "Startup, Map Frozen And Query: " << t * 1000 << "ms";
+		TEST(sum == 2 * 12345)
+		
+		tlog << "----------------";
+		
+		sum = 0;
+		tk.mark();
+		for (std::string const & key : keys) sum += parsed[key]["id"].integer();
+		t = tk.mark().seconds();
+		benchmark::DoNotOptimize(sum);
+		tlog << "Lookup Parsed Tree: " << t << "s (" << LCOUNT / t / 1000000 << " M/s)";
+		
+		aeon::int_t fsum = 0;
+		aeon::frozen::value root = mapped.root();
+		tk.mark();
+		for (std::string const & key : keys) fsum += root[key]["id"].integer();
+		t = tk.mark().seconds();
+		benchmark::DoNotOptimize(fsum);
+		TEST(sum == fsum)
+		tlog << "Lookup Frozen: " << t << "s (" << LCOUNT / t / 1000000 << " M/s)";
+		
+		tk.mark();
+		image = parsed.serialize_frozen();
+		t = tk.mark().seconds();
+		tlog << "Freeze: " << t * 1000 << "ms (" << image.size() / t / 1024 / 1024 << " MiB/s)";
+		
+		::unlink(path);
+		tlog << "================================================================";
+	}
+	
+	{ // STRICT PARSING PERFORMANCE
+		constexpr size_t RCOUNT = 200000;
+		constexpr size_t TCOUNT = 4;
+		
+		std::string json = "[";
+		for (size_t i = 0; i < RCOUNT; i++) {
+			if (i) json += ',';
+			json += meadow::strf("{\"id\":%zu,\"name\":\"record number %zu\",\"score\":%g,\"tags\":[\"alpha\",\"beta\"],\"flag\":%s}", i, i, i * 0.25, i % 2 ? "true" : "false");
+		}
+		json += "]";
+		
+		aeon::limits lim;
+		lim.max_input = json.size();
+		
+		meadow::time<CLOCK_PROCESS_CPUTIME_ID>::keeper tk;
+		
+		tlog << "================================================================";
+		tlog << "Running strict parsing performance tests";
+		tlog << TCOUNT << " iterations of " << RCOUNT << " records, " << json.size() << " bytes.";
+		tlog << "----------------";
+		
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) benchmark::DoNotOptimize(aeon::deserialize_json(json));
+		double t = tk.mark().seconds();
+		tlog << "Parse: " << t << "s (" << (json.size() * TCOUNT) / t / 1024 / 1024 << " MiB/s)";
+		
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) benchmark::DoNotOptimize(aeon::deserialize_json(json, lim));
+		t = tk.mark().seconds();
+		tlog << "Parse Strict: " << t << "s (" << (json.size() * TCOUNT) / t / 1024 / 1024 << " MiB/s)";
+		
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) aeon::validate_json(json, lim);
+		t = tk.mark().seconds();
+		tlog << "Validate: " << t << "s (" << (json.size() * TCOUNT) / t / 1024 / 1024 << " MiB/s)";
+		
+		tlog << "================================================================";
+	}
+	
+	{ // OUTPUT FORMAT PERFORMANCE
+		constexpr size_t RCOUNT = 200000;
+		constexpr size_t TCOUNT = 4;
+		
+		std::string json = "[";
+		for (size_t i = 0; i < RCOUNT; i++) {
+			if (i) json += ',';
+			json += meadow::strf("{\"name\":\"r\u00e9cord %zu\",\"id\":%zu,\"score\":%g,\"tags\":[\"alpha\",\"beta\"],\"flag\":%s}", i, i, i * 0.25, i % 2 ? "true" : "false");
+		}
+		json += "]";
+		aeon tree = aeon::deserialize_json(json);
+		
+		aeon::format pretty, canonical, ascii;
+		pretty.indent = 4;
+		canonical.canonical = true;
+		ascii.ascii = true;
+		
+		meadow::time<CLOCK_PROCESS_CPUTIME_ID>::keeper tk;
+		
+		tlog << "================================================================";
+		tlog << "Running output format performance tests";
+		tlog << TCOUNT << " iterations of " << RCOUNT << " records.";
+		tlog << "----------------";
+		
+		for (auto [name, fmt] : { std::pair { "Compact", aeon::format {} }, std::pair { "Pretty", pretty }, std::pair { "Canonical", canonical }, std::pair { "ASCII", ascii } }) {
+			size_t bytes = 0;
+			tk.mark();
+			for (size_t i = 0; i < TCOUNT; i++) bytes += tree.serialize_json(fmt).size();
+			double t = tk.mark().seconds();
+			tlog << name << ": " << t << "s (" << bytes / t / 1024 / 1024 << " MiB/s)";
+		}
+		
+		tlog << "================================================================";
+	}
+	
+	{ // NDJSON PERFORMANCE
+		constexpr size_t RCOUNT = 500000;
+		constexpr size_t TCOUNT = 4;
+		
+		std::string ndjson;
+		for (size_t i = 0; i < RCOUNT; i++)
+			ndjson += meadow::strf("{\"id\":%zu,\"name\":\"record number %zu\",\"score\":%g,\"tags\":[\"alpha\",\"beta\"],\"flag\":%s}\n", i, i, i * 0.25, i % 2 ? "true" : "false");
+		
+		// wall time, process time would sum over every worker
+		meadow::time<CLOCK_MONOTONIC>::keeper tk;
+		unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+		
+		tlog << "================================================================";
+		tlog << "Running NDJSON performance tests";
+		tlog << TCOUNT << " iterations of " << RCOUNT << " records, " << ndjson.size() << " bytes.";
+		tlog << "----------------";
+		
+		size_t records = 0;
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			aeon::deserialize_ndjson(ndjson, [&](aeon && v){ records++; benchmark::DoNotOptimize(v); }, 1);
+		}
+		double t = tk.mark().seconds();
+		TEST(records == RCOUNT * TCOUNT)
+		tlog << "NDJSON 1 Thread: " << t << "s (" << ndjson.size() * TCOUNT / t / 1048576 << " MiB/s)";
+		
+		records = 0;
+		tk.mark();
+		for (size_t i = 0; i < TCOUNT; i++) {
+			aeon::deserialize_ndjson(ndjson, [&](aeon && v){ records++; benchmark::DoNotOptimize(v); }, threads);
+		}
+		t = tk.mark().seconds();
+		TEST(records == RCOUNT * TCOUNT)
+		tlog << "NDJSON " << threads << " Threads: " << t << "s (" << ndjson.size() * TCOUNT / t / 1048576 << " MiB/s)";
+		
+		tlog << "================================================================";
+	}
 }
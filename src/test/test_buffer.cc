@@ -1,9 +1,31 @@
 #include "tests.hh"
 
 #include "meadow/buffer.hh"
+#include "meadow/time.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <bit>
+#include <cstring>
+#include <memory_resource>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
 
 using namespace meadow;
 
+static std::string_view as_view(std::span<buffer::byte_t const> s) {
+	return { reinterpret_cast<char const *>(s.data()), s.size() };
+}
+
+static void write_str(buffer & b, std::string_view str) {
+	b.write(reinterpret_cast<buffer::byte_t const *>(str.data()), str.size());
+}
+
 void test_buffer() {
 	
 	{
@@ -53,4 +75,724 @@ void test_buffer() {
 		y << 0xEFBEADDE;
 		TEST(y == b)
 	}
+	
+	// CONSUME AND PEEK
+	{
+		buffer b;
+		write_str(b, "hello world");
+		char out [16] {};
+		TEST(b.peek(reinterpret_cast<buffer::byte_t *>(out), 5) == 5 && std::string_view(out, 5) == "hello" && b.size() == 11)
+		TEST(b.read(reinterpret_cast<buffer::byte_t *>(out), 6) == 6 && std::string_view(out, 6) == "hello " && b.size() == 5)
+		TEST(as_view(b.peek()) == "world" && b[0] == 'w')
+		TEST(b.consume(100) == 5 && !b.size() && b.peek().empty())
+		
+		// a queue in steady state reuses its block instead of growing or shuffling
+		size_t cap = 0;
+		for (size_t i = 0; i < 10000; i++) {
+			write_str(b, std::string(100 + i % 7, 'x'));
+			if (i % 3 == 2) b.consume(b.size() - 10);
+			if (i == 100) cap = b.capacity();
+		}
+		TEST(b.capacity() == cap)
+	}
+	
+	// SEGMENTED
+	{
+		std::string pattern;
+		for (int i = 0; i < 1000; i++) pattern += static_cast<char>('a' + i % 26);
+		
+		buffer s = buffer::segmented(64);
+		TEST(s.is_segmented() && !s.data())
+		write_str(s, std::string_view(pattern).substr(0, 10));
+		buffer::byte_t const * first = s.data();
+		write_str(s, std::string_view(pattern).substr(10, 40));
+		for (size_t i = 50; i < 1000; i += 50) write_str(s, std::string_view(pattern).substr(i, 50));
+		TEST(s.data() == first && s.size() == 1000 && s.peek().size() == 64)
+		
+		buffer c;
+		write_str(c, pattern);
+		TEST(s == c && c == s && s.hex() == c.hex())
+		bool indexed = true;
+		for (size_t i = 0; i < 1000; i++) indexed = indexed && s[i] == pattern[i];
+		TEST(indexed)
+		
+		buffer copy = s;
+		TEST(copy == c && copy.is_segmented())
+		
+		std::string back (1000, 0);
+		TEST(s.peek(reinterpret_cast<buffer::byte_t *>(back.data()), 1000) == 1000 && back == pattern)
+		TEST(s.consume(100) == 100 && s.size() == 900 && s[0] == pattern[100])
+		TEST(s.read(reinterpret_cast<buffer::byte_t *>(back.data()), 1000) == 900 && std::string_view(back).substr(0, 900) == std::string_view(pattern).substr(100))
+		TEST(!s.size() && s.capacity() == 64)
+		
+		write_str(s, pattern);
+		s.resize(300);
+		TEST(s.size() == 300 && s[299] == pattern[299])
+		s.resize(310);
+		TEST(s.size() == 310 && s[299] == pattern[299])
+		s.linearize();
+		TEST(s.size() == 310 && s.peek().size() == 310 && as_view(s.peek()).substr(0, 300) == std::string_view(pattern).substr(0, 300))
+		write_str(s, "tail");
+		TEST(s.size() == 314 && s[313] == 'l')
+		s.clear();
+		TEST(!s.size() && s.data())
+		s.shrink_to_fit();
+		TEST(!s.capacity() && !s.data())
+	}
+	
+	// TRANSFER
+	{
+		buffer a;
+		write_str(a, "0123456789");
+		buffer::byte_t const * storage = a.data();
+		buffer b;
+		TEST(a.transfer(b) == 10 && !a.size() && b.data() == storage && as_view(b.peek()) == "0123456789")
+		
+		buffer c;
+		write_str(c, "ab");
+		TEST(b.transfer(c, 4) == 4 && as_view(c.peek()) == "ab0123" && as_view(b.peek()) == "456789")
+		TEST(b.transfer(c, 100) == 6 && as_view(c.peek()) == "ab0123456789" && !b.size())
+		TEST(b.transfer(c) == 0 && c.transfer(c) == 0)
+		
+		buffer src = buffer::segmented(16);
+		std::string data;
+		for (int i = 0; i < 100; i++) data += static_cast<char>('A' + i % 26);
+		for (size_t i = 0; i < 100; i += 16) write_str(src, std::string_view(data).substr(i, 16));
+		buffer::byte_t const * front = src.data();
+		
+		buffer dst = buffer::segmented(16);
+		write_str(dst, "xy");
+		TEST(src.transfer(dst, 40) == 40 && src.size() == 60 && dst.size() == 42)
+		TEST(dst[2] == 'A' && &dst[2] == front)
+		TEST(src[0] == static_cast<buffer::byte_t>(data[40]))
+		
+		buffer flat;
+		TEST(src.transfer(flat) == 60 && flat.peek().size() == 60 && as_view(flat.peek()) == std::string_view(data).substr(40))
+		
+		buffer all = buffer::segmented(16);
+		TEST(dst.transfer(all) == 42 && all.size() == 42 && &all[2] == front && !dst.size())
+		
+		buffer whole;
+		write_str(whole, "whole");
+		storage = whole.data();
+		TEST(whole.transfer(all) == 5 && all.size() == 47 && &all[42] == storage)
+		std::string joined (47, 0);
+		all.peek(reinterpret_cast<buffer::byte_t *>(joined.data()), 47);
+		TEST(joined == "xy" + data.substr(0, 40) + "whole")
+	}
+	
+	// DESCRIPTOR IO
+	{
+		int p [2];
+		TEST(!::pipe(p))
+		
+		std::string data;
+		for (int i = 0; i < 50000; i++) data += static_cast<char>('a' + i % 26);
+		TEST(::write(p[1], data.data(), data.size()) == static_cast<ssize_t>(data.size()))
+		
+		buffer c {16};
+		write_str(c, "0123456789");
+		c.consume(8);
+		TEST(c.read_from(p[0], 10) == 10 && c.size() == 12 && c.capacity() == 16)
+		TEST(c.read_from(p[0]) == 49990 && c.size() == 50002)
+		std::string back (50000, 0);
+		c.consume(2);
+		TEST(c.peek(reinterpret_cast<buffer::byte_t *>(back.data()), back.size()) == 50000 && back == data)
+		c.consume(c.size());
+		
+		buffer s = buffer::segmented(1024);
+		TEST(::write(p[1], data.data(), data.size()) == static_cast<ssize_t>(data.size()))
+		TEST(s.read_from(p[0], 100) == 100 && s.size() == 100)
+		ssize_t got = 100;
+		while (got < 50000) got += s.read_from(p[0], 3000);
+		TEST(got == 50000 && s.size() == 50000 && s == buffer(reinterpret_cast<buffer::byte_t const *>(data.data()), reinterpret_cast<buffer::byte_t const *>(data.data()) + data.size()))
+		
+		// short reads fill the last block before starting another
+		buffer small = buffer::segmented(4096);
+		bool filled = true;
+		for (int i = 0; i < 64; i++) {
+			TEST(::write(p[1], data.data(), 10) == 10)
+			filled = filled && small.read_from(p[0]) == 10;
+		}
+		TEST(filled && small.size() == 640 && small.capacity() == 4096)
+		TEST(::write(p[1], data.data(), 5000) == 5000)
+		TEST(small.read_from(p[0]) == 5000 && small.size() == 5640 && small.capacity() == 2 * 4096 && small.peek().size() == 4096)
+		
+				ssize_t sent = s.write_to(p[1], 20000);
+		TEST(sent == 20000 && s.size() == 30000)
+		TEST(s.write_to(p[1]) == 30000 && !s.size())
+		TEST(c.read_from(p[0], 50000) == 50000 && c == buffer(reinterpret_cast<buffer::byte_t const *>(data.data()), reinterpret_cast<buffer::byte_t const *>(data.data()) + data.size()))
+		
+		::close(p[1]);
+		TEST(c.read_from(p[0]) == 0 && s.read_from(p[0]) == 0 && !s.size())
+		::close(p[0]);
+		TEST(c.read_from(p[0]) == -1 && errno == EBADF)
+		
+		int q [2];
+		TEST(!::pipe2(q, O_NONBLOCK))
+		TEST(s.read_from(q[0]) == -1 && errno == EAGAIN && !s.size())
+		::close(q[0]);
+		::close(q[1]);
+		
+#if defined(__linux__)
+		char path [] = "/tmp/meadow_buffer_XXXXXX";
+		int f = ::mkstemp(path);
+		TEST(f >= 0)
+		TEST(::write(f, data.data(), data.size()) == static_cast<ssize_t>(data.size()))
+		::lseek(f, 1000, SEEK_SET);
+		
+		int a [2], b [2];
+		TEST(!::pipe(a) && !::pipe(b))
+		TEST(buffer::splice(f, a[1], 4000) == 4000)
+		TEST(buffer::splice(a[0], b[1], 10000) == 4000)
+		buffer out;
+		TEST(out.read_from(b[0]) == 4000 && out == buffer(reinterpret_cast<buffer::byte_t const *>(data.data()) + 1000, reinterpret_cast<buffer::byte_t const *>(data.data()) + 5000))
+		::close(a[1]);
+		TEST(buffer::splice(a[0], b[1], 10000) == 0)
+		for (int fd : { a[0], b[0], b[1], f }) ::close(fd);
+		::unlink(path);
+#endif
+	}
+	
+	// SMALL BUFFER
+	{
+		auto inside = [](auto const & sb) {
+			auto p = reinterpret_cast<char const *>(sb->data());
+			return p >= reinterpret_cast<char const *>(&sb) && p < reinterpret_cast<char const *>(&sb) + sizeof(sb);
+		};
+		
+		small_buffer<16> sb;
+		TEST(!sb->data() && !sb->size())
+		write_str(sb, "0123456789");
+		TEST(inside(sb) && sb->capacity() == 16 && as_view(sb->peek()) == "0123456789")
+		write_str(sb, "abcdefghij");
+		TEST(!inside(sb) && sb->size() == 20 && as_view(sb->peek()) == "0123456789abcdefghij")
+		sb->consume(12);
+		sb->shrink_to_fit();
+		TEST(inside(sb) && as_view(sb->peek()) == "cdefghij")
+		
+		small_buffer<16> copy { sb };
+		TEST(inside(copy) && *copy == *sb)
+		small_buffer<16> moved { std::move(copy) };
+		TEST(inside(moved) && *moved == *sb && !copy->size())
+		
+		buffer & base = moved;
+		write_str(base, "0123456789");
+		TEST(!inside(moved) && moved->size() == 18)
+		buffer taken { std::move(base) };
+		TEST(taken.size() == 18 && !moved->size() && !moved->data())
+		taken.transfer(moved, 4);
+		TEST(inside(moved) && as_view(moved->peek()) == "cdef")
+		
+		// a buffer moved out of a small one takes its inline contents along
+		buffer escaped { std::move(*moved) };
+		TEST(as_view(escaped.peek()) == "cdef" && !moved->size())
+		TEST(reinterpret_cast<char const *>(escaped.data()) < reinterpret_cast<char const *>(&moved) || reinterpret_cast<char const *>(escaped.data()) >= reinterpret_cast<char const *>(&moved) + sizeof(moved))
+		
+		// a small buffer's own storage is copied rather than relinked
+		small_buffer<64> seg { buffer::segmented(8) };
+		TEST(seg->is_segmented())
+		write_str(seg, "0123456789");
+		TEST(inside(seg) && seg->peek().size() == 10)
+		write_str(seg, std::string(100, 'x'));
+		TEST(seg->peek().size() == 64)
+		buffer dst = buffer::segmented(8);
+		TEST(seg->transfer(dst) == 110 && !seg->size() && dst.size() == 110 && dst[0] == '0' && dst[109] == 'x')
+		TEST(dst.data() < reinterpret_cast<buffer::byte_t const *>(&seg) || dst.data() >= reinterpret_cast<buffer::byte_t const *>(&seg) + sizeof(seg))
+		
+		buffer assigned;
+		assigned = sb;
+		sb = assigned;
+		TEST(inside(sb) && *sb == assigned)
+	}
+	
+	// MEMORY RESOURCES
+	{
+		std::pmr::unsynchronized_pool_resource pool;
+		std::pmr::monotonic_buffer_resource arena;
+		
+		buffer p { &pool };
+		TEST(p.resource() == &pool)
+		for (int i = 0; i < 1000; i++) write_str(p, "abcdefgh");
+		p.consume(4000);
+		p.shrink_to_fit();
+		TEST(p.size() == 4000 && p.capacity() == 4000 && p[0] == 'a')
+		
+		buffer s = buffer::segmented(256, &pool);
+		for (int i = 0; i < 100; i++) write_str(s, "0123456789");
+		buffer::byte_t * front = s.data();
+		
+		// blocks only relink between buffers of the same resource
+		buffer same = buffer::segmented(256, &pool);
+		TEST(s.transfer(same, 512) == 512 && same.data() == front)
+		buffer other = buffer::segmented(256, &arena);
+		TEST(same.transfer(other) == 512 && other.data() != front && other.resource() == &arena)
+		TEST(other[0] == '0' && other[511] == '1')
+		
+		buffer moved { std::move(s) };
+		TEST(moved.resource() == &pool && moved.size() == 488)
+		buffer heap;
+		heap = std::move(moved);
+		TEST(!heap.resource() && heap.size() == 488 && !moved.size())
+		buffer copy { other };
+		TEST(!copy.resource() && copy == other)
+		
+		small_buffer<8> sp { &arena };
+		write_str(sp, std::string(100, 'z'));
+		TEST(sp->resource() == &arena && sp->size() == 100)
+	}
+	
+	// MAPPED FILES
+	{
+		auto as_buffer = [](std::string_view str) {
+			return buffer { reinterpret_cast<buffer::byte_t const *>(str.data()), reinterpret_cast<buffer::byte_t const *>(str.data()) + str.size() };
+		};
+		
+		std::string data;
+		for (int i = 0; i < 100000; i++) data += static_cast<char>('a' + i % 26);
+		char path [] = "/tmp/meadow_buffer_XXXXXX";
+		int f = ::mkstemp(path);
+		TEST(f >= 0)
+		TEST(::write(f, data.data(), data.size()) == static_cast<ssize_t>(data.size()))
+		::close(f);
+		
+		buffer ro = buffer::map_file(path);
+		TEST(ro.is_mapped() && ro.size() == data.size() && ro.capacity() == data.size() && ro == as_buffer(data))
+		buffer::byte_t const * mapped = ro.data();
+		TEST(ro.consume(10) == 10 && ro.data() == mapped + 10 && ro[0] == 'k')
+		write_str(ro, "tail");
+		TEST(!ro.is_mapped() && ro.size() == data.size() - 6 && ro == as_buffer(data.substr(10) + "tail"))
+		
+		buffer cleared = buffer::map_file(path, buffer::mapping_t::read_only, buffer::access_t::random);
+		cleared.consume(cleared.size());
+		TEST(!cleared.size() && !cleared.is_mapped())
+		write_str(cleared, "fresh");
+		TEST(as_view(cleared.peek()) == "fresh")
+		cleared = buffer::map_file(path);
+		cleared.clear();
+		write_str(cleared, "again");
+		TEST(as_view(cleared.peek()) == "again")
+		cleared = buffer::map_file(path);
+		cleared.resize(data.size() + 1);
+		TEST(!cleared.is_mapped() && cleared.size() == data.size() + 1 && cleared[data.size() - 1] == data.back())
+		
+		// writes stay private to the buffer, growth keeps it mapped
+		buffer cow = buffer::map_file(path, buffer::mapping_t::copy_on_write, buffer::access_t::sequential);
+		TEST(cow.is_mapped() && cow.capacity() >= data.size())
+		cow[0] = 'Z';
+		std::string expect = "Z" + data.substr(1);
+		for (int i = 0; i < 64; i++) {
+			std::string more (1000 + i * 3000, static_cast<char>('0' + i % 10));
+			write_str(cow, more);
+			expect += more;
+		}
+		TEST(cow.is_mapped() && cow == as_buffer(expect))
+		buffer reread = buffer::map_file(path);
+		TEST(reread == as_buffer(data))
+		
+		// an unrelated mapping right after it forces the next growth to move it
+		buffer moved = buffer::map_file(path, buffer::mapping_t::copy_on_write);
+		write_str(moved, std::string(1 << 16, 'x'));
+		buffer::byte_t * before = moved.data();
+		size_t cap = moved.capacity();
+		void * wall = ::mmap(before + cap, 4096, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+		write_str(moved, std::string(1 << 20, 'y'));
+		TEST(moved.is_mapped() && moved.size() == data.size() + (1 << 16) + (1 << 20))
+		TEST(moved == as_buffer(data + std::string(1 << 16, 'x') + std::string(1 << 20, 'y')))
+		if (wall == before + cap) TEST(moved.data() != before)
+		if (wall != MAP_FAILED) ::munmap(wall, 4096);
+		
+		// mapped blocks relink like any other
+		buffer seg = buffer::segmented(1024);
+		write_str(seg, "head");
+		size_t whole = moved.size();
+		TEST(moved.transfer(seg) == whole && seg.size() == 4 + whole && seg[4] == 'a')
+		TEST(seg.consume(seg.size()) && !seg.size())
+		
+		buffer copy { cow };
+		TEST(!copy.is_mapped() && copy == cow)
+		small_buffer<16> sb { buffer::map_file(path) };
+		TEST(sb->is_mapped() && sb->size() == data.size())
+		
+		::truncate(path, 0);
+		TEST(!buffer::map_file(path).size() && !buffer::map_file(path).is_mapped())
+		::unlink(path);
+		bool thrown = false;
+		try {
+			(void)buffer::map_file(path);
+		} catch (std::system_error const & e) {
+			thrown = e.code() == std::errc::no_such_file_or_directory;
+		}
+		TEST(thrown)
+	}
+	
+	// BINARY CODEC
+	{
+		enum class color : uint16_t { red = 1, blue = 0x0203 };
+		std::vector<uint32_t> values { 1, 0x01020304, 0xFFFFFFFF };
+		std::vector<buffer::byte_t> blob { 0, 1, 2, 0xFF };
+		
+		auto encode = [&](buffer & b) {
+			buffer::writer w { b };
+			w.fixed<std::endian::big>(uint32_t { 0x01020304 });
+			w.fixed<std::endian::little>(uint32_t { 0x01020304 });
+			w.varint(300);
+			w.zigzag(-1);
+			w.string("hi");
+			w.bytes(blob);
+			w.fixed(int8_t { -5 });
+			w.fixed<std::endian::big>(color::blue);
+			w.fixed<std::endian::big>(1.5);
+			w.fixed(0.25f);
+			for (uint64_t v : { uint64_t { 0 }, uint64_t { 127 }, uint64_t { 128 }, uint64_t { 1 } << 35, std::numeric_limits<uint64_t>::max() }) w.varint(v);
+			for (int64_t v : { int64_t { 0 }, int64_t { 1 }, int64_t { -64 }, std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max() }) w.zigzag(v);
+			w.array<std::endian::big>(std::span<uint32_t const> { values });
+			w.array(std::span<uint32_t const> { values });
+			w.string(std::string(3000, 'q'));
+		};
+		auto decode = [&](buffer & b) {
+			buffer::reader r { b };
+			bool ok = r.fixed<uint32_t, std::endian::big>() == 0x01020304 && r.fixed<uint32_t>() == 0x01020304;
+			ok = ok && r.varint() == 300 && r.zigzag() == -1 && r.string() == "hi" && r.bytes() == blob;
+			ok = ok && r.fixed<int8_t>() == -5 && r.fixed<color, std::endian::big>() == color::blue;
+			ok = ok && r.fixed<double, std::endian::big>() == 1.5 && r.fixed<float>() == 0.25f;
+			for (uint64_t v : { uint64_t { 0 }, uint64_t { 127 }, uint64_t { 128 }, uint64_t { 1 } << 35, std::numeric_limits<uint64_t>::max() }) ok = ok && r.varint() == v;
+			for (int64_t v : { int64_t { 0 }, int64_t { 1 }, int64_t { -64 }, std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max() }) ok = ok && r.zigzag() == v;
+			std::vector<uint32_t> be (3), le (3);
+			r.array<std::endian::big>(std::span<uint32_t> { be });
+			r.array(std::span<uint32_t> { le });
+			ok = ok && be == values && le == values && r.string() == std::string(3000, 'q');
+			return ok;
+		};
+		
+		buffer b;
+		encode(b);
+		std::string hex = b.hex(true);
+		TEST(hex.substr(0, 16) == "0102030404030201")
+		TEST(hex.substr(16, 14) == "ac0201026869" + std::string("04"))
+		TEST(hex.substr(30, 8) == "000102ff" && hex.substr(38, 6) == "fb0203")
+		TEST(decode(b) && !b.size())
+		
+		// blocks smaller than some of the values, so that reads and writes straddle them
+		for (size_t block : { 1, 3, 7, 64 }) {
+			buffer s = buffer::segmented(block);
+			for (int i = 0; i < 5; i++) encode(s);
+			TEST(s.size() == 5 * static_cast<size_t>(hex.size() / 2))
+			bool ok = true;
+			for (int i = 0; i < 5; i++) ok = ok && decode(s);
+			TEST(ok && !s.size())
+		}
+		
+		// nothing is part of the buffer before committing, nor consumed from it
+		buffer c;
+		{
+			buffer::writer w { c };
+			w.varint(1);
+			TEST(!c.size())
+			w.commit();
+			TEST(c.size() == 1)
+			w.reserve(100);
+			w.zigzag(-2);
+		}
+		TEST(c.size() == 2)
+		{
+			buffer::reader r { c };
+			TEST(r.varint() == 1 && r.remaining() == 1 && c.size() == 2)
+			r.commit();
+			TEST(c.size() == 1 && r.zigzag() == -2 && c.size() == 1)
+		}
+		TEST(!c.size())
+		
+		auto throws = [](auto && fn, auto const & tag) {
+			using E = std::remove_cvref_t<decltype(tag)>;
+			try {
+				fn();
+			} catch (E const &) {
+				return true;
+			}
+			return false;
+		};
+		buffer e;
+		write_str(e, "\x80\x80");
+		TEST(throws([&]{ buffer::reader r { e }; (void)r.varint(); }, std::out_of_range { "" }))
+		e.clear();
+		write_str(e, std::string(11, '\xFF'));
+		TEST(throws([&]{ buffer::reader r { e }; (void)r.varint(); }, std::overflow_error { "" }))
+		e.clear();
+		write_str(e, "\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x02");
+		TEST(throws([&]{ buffer::reader r { e }; (void)r.varint(); }, std::overflow_error { "" }))
+		e.clear();
+		write_str(e, "\x05" "abc");
+		TEST(throws([&]{ buffer::reader r { e }; (void)r.string(); }, std::out_of_range { "" }))
+		e.clear();
+		write_str(e, "abc");
+		TEST(throws([&]{ buffer::reader r { e }; (void)r.fixed<uint32_t>(); }, std::out_of_range { "" }))
+		TEST(throws([&]{ buffer::reader r { e }; r.skip(4); }, std::out_of_range { "" }))
+		{
+			buffer::reader r { e };
+			r.skip(2);
+			TEST(r.fixed<uint8_t>() == 'c' && !r.remaining())
+		}
+	}
+	
+	{ // BUFFER PERFORMANCE
+		constexpr size_t CHUNK = 1 << 12;
+		constexpr size_t TOTAL = 1 << 28;
+		
+		std::vector<buffer::byte_t> chunk (CHUNK, 0xAB);
+		std::vector<buffer::byte_t> sink (CHUNK * 4);
+		
+		meadow::time<CLOCK_PROCESS_CPUTIME_ID>::keeper tk;
+		
+		tlog << "================================================================";
+		tlog << "Running buffer performance tests";
+		tlog << (TOTAL >> 20) << " MiB in " << CHUNK << " byte writes.";
+		tlog << "----------------";
+		
+		for (bool segmented : { false, true }) {
+			buffer b = segmented ? buffer::segmented() : buffer {};
+			tk.mark();
+			for (size_t i = 0; i < TOTAL / CHUNK; i++) {
+				b.write(chunk.data(), CHUNK);
+				if (i % 4 == 3) b.read(sink.data(), sink.size() - CHUNK / 2);
+			}
+			double t = tk.mark().seconds();
+			tlog << (segmented ? "Queue Segmented: " : "Queue Contiguous: ") << t << "s (" << (TOTAL >> 20) / t << " MiB/s)";
+		}
+		
+		for (bool segmented : { false, true }) {
+			buffer src = segmented ? buffer::segmented() : buffer {};
+			buffer dst = segmented ? buffer::segmented() : buffer {};
+			for (size_t i = 0; i < (TOTAL >> 2) / CHUNK; i++) src.write(chunk.data(), CHUNK);
+			write_str(dst, "header");
+			tk.mark();
+			size_t moved = 0;
+			while (src.size()) moved += src.transfer(dst, 1 << 20);
+			double t = tk.mark().seconds();
+			TEST(moved == TOTAL >> 2 && dst.size() == moved + 6)
+			tlog << (segmented ? "Transfer Segmented: " : "Transfer Contiguous: ") << t * 1000 << "ms (" << (moved >> 20) / t << " MiB/s)";
+		}
+		
+		tlog << "----------------";
+		
+		// many short-lived buffers holding a few bytes, e.g. message headers
+		constexpr size_t SMALL_COUNT = 1 << 22;
+		auto small = [&](char const * name, auto && make) {
+			size_t total = 0;
+			tk.mark();
+			for (size_t i = 0; i < SMALL_COUNT; i++) {
+				auto b = make();
+				buffer & ref = b;
+				ref.write(static_cast<uint32_t>(i));
+				ref.write(chunk.data(), i % 12);
+				total += ref.size();
+				benchmark::DoNotOptimize(ref.data());
+			}
+			double t = tk.mark().seconds();
+			TEST(total)
+			tlog << name << t * 1000 << "ms (" << SMALL_COUNT / t / 1000000 << " M/s)";
+		};
+		
+		small("Small Heap: ", [] { return buffer {}; });
+		small("Small Inline: ", [] { return small_buffer<16> {}; });
+		static thread_local std::pmr::unsynchronized_pool_resource pool;
+		small("Small Pool: ", [] { return buffer { &pool }; });
+		// an arena per batch of requests, released once each batch is done
+		std::pmr::monotonic_buffer_resource arena { 1 << 20 };
+		size_t made = 0;
+		small("Small Arena: ", [&] {
+			if (!(++made % 4096)) arena.release();
+			return buffer { &arena };
+		});
+		
+		tlog << "----------------";
+		
+		// loading a file, then reading every page of it
+		{
+			constexpr size_t FILE_SIZE = 1 << 28;
+			char path [] = "/tmp/meadow_buffer_XXXXXX";
+			int f = ::mkstemp(path);
+			TEST(f >= 0)
+			std::vector<buffer::byte_t> fill (1 << 20, 0x5A);
+			for (size_t i = 0; i < FILE_SIZE; i += fill.size()) TEST(::write(f, fill.data(), fill.size()) == static_cast<ssize_t>(fill.size()))
+			::close(f);
+			
+			auto scan = [](buffer const & b) {
+				uint64_t sum = 0;
+				for (size_t i = 0; i < b.size(); i += 4096) sum += b[i];
+				return sum;
+			};
+			auto load = [&](char const * name, auto && open) {
+				tk.mark();
+				buffer b = open();
+				double t_load = tk.mark().seconds();
+				uint64_t sum = scan(b);
+				double t_scan = tk.mark().seconds();
+				TEST(b.size() == FILE_SIZE && sum == (FILE_SIZE / 4096) * 0x5A)
+				tlog << name << t_load * 1000 << "ms, then touching every page " << t_scan * 1000 << "ms";
+			};
+			
+			load("Load read_from: ", [&] {
+				int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+				buffer b { FILE_SIZE };
+				while (b.read_from(fd, FILE_SIZE - b.size()) > 0);
+				::close(fd);
+				return b;
+			});
+			load("Load map_file: ", [&] { return buffer::map_file(path); });
+			load("Load map_file (sequential): ", [&] { return buffer::map_file(path, buffer::mapping_t::read_only, buffer::access_t::sequential); });
+			load("Load map_file (will_need): ", [&] { return buffer::map_file(path, buffer::mapping_t::read_only, buffer::access_t::will_need); });
+			
+			buffer cow = buffer::map_file(path, buffer::mapping_t::copy_on_write);
+			tk.mark();
+			for (size_t i = 0; i < 64; i++) cow.write(fill.data(), fill.size());
+			double t = tk.mark().seconds();
+			TEST(cow.is_mapped() && cow.size() == FILE_SIZE + 64 * fill.size())
+			tlog << "Append to mapping: " << t * 1000 << "ms for " << (64 * fill.size() >> 20) << " MiB";
+			::unlink(path);
+		}
+		
+		tlog << "----------------";
+		
+		// records of a typical wire format
+		{
+			struct record {
+				uint64_t id;
+				int64_t delta;
+				uint32_t flags;
+				double value;
+				std::string name;
+			};
+			constexpr size_t RECORDS = 1 << 21;
+			std::vector<record> records (RECORDS);
+			for (size_t i = 0; i < RECORDS; i++) records[i] = { i * 977, static_cast<int64_t>(i % 200) - 100, static_cast<uint32_t>(i), i * 0.5, "name-" + std::to_string(i % 1000) };
+			
+			auto encode = [&](char const * name, auto && fn) {
+				buffer b;
+				tk.mark();
+				fn(b);
+				double t = tk.mark().seconds();
+				tlog << name << t * 1000 << "ms (" << RECORDS / t / 1000000 << " M records/s, " << (b.size() >> 20) << " MiB)";
+				return b;
+			};
+			
+			encode("Encode write() per field: ", [&](buffer & b) {
+				for (record const & r : records) {
+					b << r.id << r.delta << r.flags << r.value << static_cast<uint32_t>(r.name.size());
+					b.write(reinterpret_cast<buffer::byte_t const *>(r.name.data()), r.name.size());
+				}
+			});
+			auto put = [](buffer::writer & w, record const & r) {
+				w.varint(r.id);
+				w.zigzag(r.delta);
+				w.fixed<std::endian::big>(r.flags);
+				w.fixed(r.value);
+				w.string(r.name);
+			};
+			encode("Encode writer: ", [&](buffer & b) {
+				buffer::writer w { b };
+				for (record const & r : records) put(w, r);
+			});
+			buffer encoded = encode("Encode writer, reserve per record: ", [&](buffer & b) {
+				buffer::writer w { b };
+				for (record const & r : records) {
+					w.reserve(40 + r.name.size());
+					put(w, r);
+				}
+			});
+			
+			tk.mark();
+			size_t matched = 0;
+			{
+				buffer::reader rd { encoded };
+				for (record const & r : records) {
+					uint64_t id = rd.varint();
+					int64_t delta = rd.zigzag();
+					uint32_t flags = rd.fixed<uint32_t, std::endian::big>();
+					double value = rd.fixed<double>();
+					std::string name = rd.string();
+					matched += id == r.id && delta == r.delta && flags == r.flags && value == r.value && name == r.name;
+				}
+			}
+			double t = tk.mark().seconds();
+			TEST(matched == RECORDS && !encoded.size())
+			tlog << "Decode reader: " << t * 1000 << "ms (" << RECORDS / t / 1000000 << " M records/s)";
+			
+			std::vector<uint32_t> words (1 << 24);
+			std::iota(words.begin(), words.end(), 0);
+			buffer out;
+			out.reserve(words.size() * 4);
+			tk.mark();
+			{
+				buffer::writer w { out };
+				for (uint32_t v : words) w.fixed<std::endian::big>(v);
+			}
+			double t_each = tk.mark().seconds();
+			out.clear();
+			{
+				buffer::writer w { out };
+				w.array<std::endian::big>(std::span<uint32_t const> { words });
+			}
+			double t_bulk = tk.mark().seconds();
+			TEST(out.size() == words.size() * 4 && out[7] == 1)
+			tlog << "Big endian u32, each: " << t_each * 1000 << "ms, array: " << t_bulk * 1000 << "ms (" << (out.size() >> 20) << " MiB)";
+		}
+		
+		tlog << "----------------";
+		
+		// proxying between pipes, fed and drained by other threads
+		constexpr size_t PROXY_TOTAL = 1 << 28;
+		auto proxy = [&](char const * name, auto && step) {
+			int in [2], out [2];
+			TEST(!::pipe(in) && !::pipe(out))
+			std::thread producer {[&]{
+				std::vector<buffer::byte_t> feed (1 << 16, 0xCD);
+				for (size_t sent = 0; sent < PROXY_TOTAL; sent += feed.size()) TEST(::write(in[1], feed.data(), feed.size()) == static_cast<ssize_t>(feed.size()))
+				::close(in[1]);
+			}};
+			size_t received = 0;
+			std::thread consumer {[&]{
+				std::vector<buffer::byte_t> drain (1 << 16);
+				for (ssize_t n; (n = ::read(out[0], drain.data(), drain.size())) > 0;) received += n;
+			}};
+			
+			meadow::time<CLOCK_MONOTONIC>::keeper wall;
+			meadow::time<CLOCK_THREAD_CPUTIME_ID>::keeper cpu;
+			wall.mark();
+			cpu.mark();
+			while (step(in[0], out[1]));
+			double c = cpu.mark().seconds();
+			::close(out[1]);
+			consumer.join();
+			double t = wall.mark().seconds();
+			producer.join();
+			::close(in[0]);
+			::close(out[0]);
+			TEST(received == PROXY_TOTAL)
+			tlog << name << t << "s (" << (PROXY_TOTAL >> 20) / t << " MiB/s), proxy thread CPU " << c << "s";
+		};
+		
+		std::vector<buffer::byte_t> temp (1 << 16);
+		proxy("Proxy read/write: ", [&](int in, int out) {
+			ssize_t n = ::read(in, temp.data(), temp.size());
+			if (n <= 0) return false;
+			for (ssize_t w = 0; w < n;) w += ::write(out, temp.data() + w, n - w);
+			return true;
+		});
+		
+		buffer staging = buffer::segmented(1 << 16);
+		proxy("Proxy read_from/write_to: ", [&](int in, int out) {
+			if (staging.read_from(in) <= 0) return false;
+			while (staging.size()) staging.write_to(out);
+			return true;
+		});
+		
+#if defined(__linux__)
+		proxy("Proxy splice: ", [&](int in, int out) {
+			return buffer::splice(in, out, 1 << 16) > 0;
+		});
+#endif
+		
+		tlog << "================================================================";
+	}
 }